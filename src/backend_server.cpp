@@ -6,6 +6,8 @@ using namespace StructBX::Functions;
 BackendServer::BackendServer() :
     space_id_cookie_(NAF::Tools::SettingsManager::GetSetting_("space_id_cookie_name", "1f3efd18688d2"), "")
     ,add_space_id_cookie_(false)
+    ,token_cookie_(Tools::SessionToken::CookieName_(), "")
+    ,add_token_cookie_(false)
 {
 
 }
@@ -20,27 +22,52 @@ void BackendServer::AddFunctions_()
     // Add all functions
     for(auto it : *function_data_.get_functions())
         get_functions_manager().get_functions().insert(std::make_pair(it->get_endpoint(), it));
+
+    // Endpoint registry of the permissions table
+    Tools::PermissionsTable::Compile_(*function_data_.get_functions());
 }
 
 void BackendServer::Process_()
 {
+    Tools::WorkerModel::Scope worker_scope;
+    if(!Tools::WorkerModel::KeepAlive_())
+        get_http_server_response().value()->setKeepAlive(false);
+
+    // Shed load before any work is done, the client retries later
+    auto path = Poco::URI(get_http_server_request().value()->getURI()).getPath();
+    Tools::AdmissionControl::Ticket ticket(Tools::AdmissionControl::Classify_(get_properties().method, path));
+    if(!ticket.Admitted_())
+    {
+        get_http_server_response().value()->set("Retry-After", std::to_string(ticket.RetryAfter_()));
+        JSONResponse_(HTTP::Status::kHTTP_SERVICE_UNAVAILABLE, "The server is busy, try again later.");
+        return;
+    }
+
     get_files_parameters()->set_directory_base(NAF::Tools::SettingsManager::GetSetting_("directory_base", "/var/www"));
     
     // Set security type
     set_security_type(Extras::SecurityType::kDisableAll);
     
-    // Process the request body
+    // Process the request body, the time of slow uploads doesn't shrink the limit
     ManageRequestBody_();
+    ticket.Restart_();
 
-    // Verify sessions
-    if(!VerifySession_())
+    // Verify the signed token, a recently verified session or the session itself
+    bool token_verified = VerifyToken_();
+    bool session_cached = !token_verified && VerifyCachedSession_();
+    if(!token_verified && !session_cached)
     {
-        JSONResponse_(HTTP::Status::kHTTP_UNAUTHORIZED, "Session not found.");
-        return;
+        if(!VerifySession_())
+        {
+            JSONResponse_(HTTP::Status::kHTTP_UNAUTHORIZED, "Session not found.");
+            return;
+        }
+        CacheSession_();
     }
 
     // Setup Function Data
-    SetupFunctionData_();
+    if(!token_verified)
+        SetupFunctionData_();
 
     // Add functions
     AddFunctions_();
@@ -56,64 +83,224 @@ void BackendServer::Process_()
     if(add_space_id_cookie_)
         get_current_function()->AddCookie_(space_id_cookie_);
 
+    // Setup token cookie, a space change drops it so the next token carries the new space
+    if(Tools::SessionToken::Enabled_() && get_current_function()->get_endpoint() == "/api/spaces/change")
+    {
+        Net::HTTPCookie cookie(Tools::SessionToken::CookieName_(), "");
+        cookie.setPath("/");
+        cookie.setMaxAge(0);
+        get_current_function()->AddCookie_(HTTP::Cookie(cookie));
+    }
+    else if(add_token_cookie_)
+        get_current_function()->AddCookie_(token_cookie_);
+
     // Verify permissions
-    if(!VerifyPermissions_())
+    if(!VerifyCompiledPermissions_())
     {
         JSONResponse_(HTTP::Status::kHTTP_UNAUTHORIZED, "The user does not have the permissions to perform this operation.");
         return;
     }
 
+    // Fair share between spaces, a busy space waits for its own requests without
+    // holding an admission slot or counting the wait as latency
+    bool space_queue = Tools::SpaceScheduler::Enabled_();
+    if(space_queue)
+        ticket.Suspend_();
+    Tools::SpaceScheduler::Ticket space_ticket(function_data_.get_space_id());
+    if(!space_ticket.Admitted_())
+    {
+        get_http_server_response().value()->set("Retry-After", "1");
+        JSONResponse_(HTTP::Status::kHTTP_SERVICE_UNAVAILABLE, "The space has too many requests in progress, try again later.");
+        return;
+    }
+    if(space_queue && !ticket.Resume_())
+    {
+        get_http_server_response().value()->set("Retry-After", std::to_string(ticket.RetryAfter_()));
+        JSONResponse_(HTTP::Status::kHTTP_SERVICE_UNAVAILABLE, "The server is busy, try again later.");
+        return;
+    }
+
+    // Writes keep the user on the primary for a while, so it reads what it wrote
+    bool write = get_properties().method != "GET";
+    if(write)
+        Tools::ReplicaRouter::MarkWrite_(function_data_.get_id_user());
+
     // Process actions
     ProcessActions_();
+    if(write)
+        Tools::ReplicaRouter::MarkWrite_(function_data_.get_id_user());
+
+    // Drop cached memberships changed by this request
+    InvalidateMemberships_();
 }
 
 void BackendServer::SetupFunctionData_()
 {
     // Setup User ID
     function_data_.set_id_user(get_users_manager().get_current_user().get_id());
+
+    // Memberships of the current user, from memory
+    auto membership = Tools::MembershipCache::Get_(function_data_.get_id_user());
+    function_data_.set_organization_id(membership.organization_id);
     
     // Get Cookie Space ID
     Poco::Net::NameValueCollection cookies;
     get_http_server_request().value()->getCookies(cookies);
     auto cookie_space_id = cookies.find(NAF::Tools::SettingsManager::GetSetting_("space_id_cookie_name", "1f3efd18688d2"));
 
-    // Set Space ID if exists in Cookies
+    // Set Space ID if exists in Cookies and the user still belongs to it
     if(cookie_space_id != cookies.end())
     {
         auto space_id_decoded = NAF::Tools::Base64Tool().Decode_(cookie_space_id->second);
-        function_data_.set_space_id(space_id_decoded);
-    }
-    else
-    {
-        add_space_id_cookie_ = true;
-
-        // Get Space ID Cookie if not exists in Cookies
-        auto action = NAF::Functions::Action("a1");
-        action.set_sql_code(
-            "SELECT s.id " \
-            "FROM spaces s " \
-            "JOIN spaces_users su ON su.id_space = s.id " \
-            "WHERE su.id_naf_user = ? LIMIT 1"
-        );
-        action.AddParameter_("id_naf_user", function_data_.get_id_user(), false);
-        if(action.Work_())
+        if(membership.spaces.find(space_id_decoded) != membership.spaces.end())
         {
-            auto space_id = action.get_results()->First_();
-            if(!space_id->IsNull_())
-            {
-                // Set Space ID
-                function_data_.set_space_id(space_id->ToString_());
-
-                // Save Space ID to Cookie
-                auto space_id_encoded = NAF::Tools::Base64Tool().Encode_(space_id->ToString_());
-
-                Net::HTTPCookie cookie(NAF::Tools::SettingsManager::GetSetting_("space_id_cookie_name", "1f3efd18688d2"), space_id_encoded);
-                cookie.setPath("/");
-                cookie.setSameSite(Net::HTTPCookie::SAME_SITE_STRICT);
-                cookie.setSecure(true);
-                cookie.setHttpOnly();
-                space_id_cookie_ = HTTP::Cookie(cookie);
-            }
+            function_data_.set_space_id(space_id_decoded);
+            SetupToken_(membership);
+            return;
         }
     }
-}
\ No newline at end of file
+
+    // Get Space ID Cookie if not exists in Cookies
+    add_space_id_cookie_ = true;
+    if(membership.first_space != "")
+    {
+        // Set Space ID
+        function_data_.set_space_id(membership.first_space);
+
+        // Save Space ID to Cookie
+        auto space_id_encoded = NAF::Tools::Base64Tool().Encode_(membership.first_space);
+
+        Net::HTTPCookie cookie(NAF::Tools::SettingsManager::GetSetting_("space_id_cookie_name", "1f3efd18688d2"), space_id_encoded);
+        cookie.setPath("/");
+        cookie.setSameSite(Net::HTTPCookie::SAME_SITE_STRICT);
+        cookie.setSecure(true);
+        cookie.setHttpOnly();
+        space_id_cookie_ = HTTP::Cookie(cookie);
+    }
+
+    // Signed token for the next requests
+    SetupToken_(membership);
+}
+
+bool BackendServer::VerifyToken_()
+{
+    if(!Tools::SessionToken::Enabled_())
+        return false;
+
+    Poco::Net::NameValueCollection cookies;
+    get_http_server_request().value()->getCookies(cookies);
+    auto token = cookies.find(Tools::SessionToken::CookieName_());
+    if(token == cookies.end())
+        return false;
+
+    Tools::SessionToken::Claims claims;
+    if(!Tools::SessionToken::Verify_(token->second, claims))
+        return false;
+
+    // The user comes from the token, SessionsManager is not touched
+    get_users_manager().get_current_user().set_id(claims.id_user);
+    get_users_manager().get_current_user().set_id_group(claims.id_group);
+
+    function_data_.set_id_user(claims.id_user);
+    function_data_.set_space_id(claims.space_id);
+    function_data_.set_organization_id(claims.organization_id);
+
+    return true;
+}
+
+bool BackendServer::VerifyCachedSession_()
+{
+    if(!Tools::SessionStore::Enabled_())
+        return false;
+
+    Poco::Net::NameValueCollection cookies;
+    get_http_server_request().value()->getCookies(cookies);
+    session_key_ = Tools::SessionStore::Key_(cookies);
+    if(session_key_ == "")
+        return false;
+
+    Tools::SessionStore::Entry entry;
+    if(!Tools::SessionStore::Find_(session_key_, entry))
+        return false;
+
+    get_users_manager().get_current_user().set_id(entry.id_user);
+    get_users_manager().get_current_user().set_id_group(entry.id_group);
+
+    return true;
+}
+
+void BackendServer::CacheSession_()
+{
+    if(session_key_ == "")
+        return;
+
+    // The user and group that SessionsManager has just verified
+    auto& user = get_users_manager().get_current_user();
+    Tools::SessionStore::Insert_(session_key_, user.get_id(), user.get_id_group());
+}
+
+void BackendServer::SetupToken_(Tools::MembershipCache::Membership& membership)
+{
+    if(!Tools::SessionToken::Enabled_())
+        return;
+
+    Tools::SessionToken::Claims claims;
+    claims.id_user = function_data_.get_id_user();
+    claims.space_id = function_data_.get_space_id();
+    claims.organization_id = membership.organization_id;
+    try
+    {
+        claims.id_group = std::stoi(membership.group_id);
+    }
+    catch(std::exception&)
+    {
+        return;
+    }
+
+    Net::HTTPCookie cookie(Tools::SessionToken::CookieName_(), Tools::SessionToken::Issue_(claims));
+    cookie.setPath("/");
+    cookie.setSameSite(Net::HTTPCookie::SAME_SITE_STRICT);
+    cookie.setSecure(true);
+    cookie.setHttpOnly();
+    token_cookie_ = HTTP::Cookie(cookie);
+    add_token_cookie_ = true;
+}
+
+bool BackendServer::VerifyCompiledPermissions_()
+{
+    auto id_group = get_users_manager().get_current_user().get_id_group();
+    auto endpoint = get_current_function()->get_endpoint();
+    auto method = get_properties().method;
+
+    return Tools::PermissionsTable::Verify_(id_group, endpoint, method, [this]()
+    {
+        return VerifyPermissions_();
+    });
+}
+
+void BackendServer::InvalidateMemberships_()
+{
+    // Endpoints that change spaces_users, organizations_users or the group of a user
+    static const std::set<std::string> endpoints = {
+        "/api/spaces/delete"
+        ,"/api/spaces/users/add"
+        ,"/api/spaces/users/delete"
+        ,"/api/organizations/users/add"
+        ,"/api/organizations/users/modify"
+        ,"/api/organizations/users/delete"
+    };
+
+    // A new space only adds the current user, tokens carry memberships so they go too
+    auto endpoint = get_current_function()->get_endpoint();
+    if(endpoint == "/api/spaces/add")
+    {
+        Tools::MembershipCache::Invalidate_(function_data_.get_id_user());
+        Tools::SessionToken::RevokeUser_(function_data_.get_id_user());
+    }
+    else if(endpoints.find(endpoint) != endpoints.end())
+    {
+        Tools::MembershipCache::InvalidateAll_();
+        Tools::SessionToken::RevokeAll_();
+        Tools::SessionStore::Clear_();
+    }
+}
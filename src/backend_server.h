@@ -2,10 +2,22 @@
 #ifndef STRUCTBX_BACKENDSERVER
 #define STRUCTBX_BACKENDSERVER
 
+#include <set>
+
+#include "Poco/URI.h"
+
 #include "core/nebula_atom.h"
 #include "handlers/backend_handler.h"
 
 #include "tools/function_data.h"
+#include "tools/membership_cache.h"
+#include "tools/session_token.h"
+#include "tools/session_store.h"
+#include "tools/permissions_table.h"
+#include "tools/replica_router.h"
+#include "tools/worker_model.h"
+#include "tools/admission_control.h"
+#include "tools/space_scheduler.h"
 #include "functions/organizations/main.h"
 #include "functions/spaces/main.h"
 #include "functions/forms/main.h"
@@ -30,11 +42,20 @@ class StructBX::BackendServer : public Handlers::BackendHandler
 
     protected:
         void SetupFunctionData_();
+        bool VerifyToken_();
+        bool VerifyCachedSession_();
+        void CacheSession_();
+        bool VerifyCompiledPermissions_();
+        void SetupToken_(Tools::MembershipCache::Membership& membership);
+        void InvalidateMemberships_();
 
     private:
         Tools::FunctionData function_data_;
         HTTP::Cookie space_id_cookie_;
         bool add_space_id_cookie_;
+        HTTP::Cookie token_cookie_;
+        bool add_token_cookie_;
+        std::string session_key_;
 };
 
 #endif //STRUCTBX_BACKENDSERVER
\ No newline at end of file
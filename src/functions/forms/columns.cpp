@@ -148,7 +148,7 @@ void Columns::Add_()
             "ADD " + column + " " + variables.column_type + variables.length + " " +
             variables.required + " " + variables.default_value
         );
-        if(!action4->Work_())
+        if(!Tools::ShardMap::Work_(action4, space_id))
         {
             delete_column_table(column_id);
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action4->get_identifier() + ": " + action4->get_custom_error());
@@ -189,7 +189,7 @@ void Columns::Add_()
                     "(_structbx_column_" + column_id_link->ToString_() + ") " + 
                     variables.cascade_key_condition
             );
-            if(!action6->Work_())
+            if(!Tools::ShardMap::Work_(action6, space_id))
             {
                 self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action6->get_identifier() + ": No se pudo crear la llave foránea");
                 return;
@@ -274,7 +274,7 @@ void Columns::Modify_()
             " " + variables.column_type + variables.length + " " + variables.required +
             " " + variables.default_value
         );
-        if(!action4->Work_())
+        if(!Tools::ShardMap::Work_(action4, space_id))
         {
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action4->get_identifier() + ": " + action4->get_custom_error());
             return;
@@ -347,7 +347,7 @@ void Columns::Delete_()
             "DROP FOREIGN KEY IF EXISTS _IDX_structbx_column_" + column_id->ToString_());
 
         // Execute actions
-        if(!action2_0->Work_())
+        if(!Tools::ShardMap::Work_(action2_0, space_id))
         {
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2_0->get_identifier() + ": " + action2_0->get_custom_error());
             return;
@@ -359,7 +359,7 @@ void Columns::Delete_()
             "DROP COLUMN IF EXISTS _structbx_column_" + column_id->ToString_());
 
         // Execute actions
-        if(!action2->Work_())
+        if(!Tools::ShardMap::Work_(action2, space_id))
         {
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2->get_identifier() + ": " + action2->get_custom_error());
             return;
@@ -4,6 +4,7 @@
 
 #include "tools/function_data.h"
 #include "tools/actions_data.h"
+#include "tools/shard_map.h"
 
 namespace StructBX
 {
@@ -13,8 +13,13 @@ Forms::Data::Data(Tools::FunctionData& function_data) :
     ReadSpecific_();
     ReadFile_();
     Add_();
+    AddBulk_();
+    Import_();
+    ReadImport_();
     Modify_();
+    ModifyBulk_();
     Delete_();
+    DeleteBulk_();
 }
 
 void Forms::Data::ReadChangeInt_()
@@ -23,10 +28,12 @@ void Forms::Data::ReadChangeInt_()
     NAF::Functions::Function::Ptr function = 
         std::make_shared<NAF::Functions::Function>("/api/forms/data/read/changeInt", HTTP::EnumMethods::kHTTP_GET);
 
-    // Action 1: Get Change int
+    function->set_response_type(NAF::Functions::Function::ResponseType::kCustom);
+
+    // Action 1: Get stored Change int
     auto action1 = function->AddAction_("a1");
     action1->set_sql_code(
-        "SELECT f.change_int "
+        "SELECT f.change_int AS stored_change_int "
         "FROM forms f "
         "WHERE f.identifier = ? AND f.id_space = ?"
     );
@@ -43,6 +50,38 @@ void Forms::Data::ReadChangeInt_()
     });
     action1->AddParameter_("id_space", get_space_id(), false);
 
+    // Setup Custom Process
+    auto id_space = get_space_id();
+    function->SetupCustomProcess_([id_space, action1](NAF::Functions::Function& self)
+    {
+        // Execute actions
+        if(!Tools::RoutedAction::Prepared_(*action1))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": " + action1->get_custom_error());
+            return;
+        }
+
+        // Add the in-memory Change int, it includes increments not flushed yet
+        auto form_identifier = self.GetParameter_("form-identifier");
+        if(form_identifier != self.get_parameters().end())
+        {
+            for(auto row : *action1->get_results())
+            {
+                auto stored_change_int = row->ExtractField_("stored_change_int");
+                if(stored_change_int->IsNull_())
+                    continue;
+
+                int change_int;
+                if(!Tools::FormCounters::ReadChangeInt_(form_identifier->get()->ToString_(), id_space, change_int))
+                    change_int = stored_change_int->Int_();
+                row->AddField_("change_int", NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(change_int)));
+            }
+        }
+
+        // Send results
+        self.CompoundResponse_(HTTP::Status::kHTTP_OK, action1->CreateJSONResult_());
+    });
+
     get_functions()->push_back(function);
 }
 
@@ -64,17 +103,16 @@ void Forms::Data::Read_()
 
     // Setup Custom Process
     auto id_space = get_space_id();
-    function->SetupCustomProcess_([id_space, action1_0, action1](NAF::Functions::Function& self)
+    auto id_user = get_id_user();
+    function->SetupCustomProcess_([id_space, id_user, action1_0, action1](NAF::Functions::Function& self)
     {
-        // Execute actions
-        if(!action1_0->Work_())
-        {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1_0->get_identifier() + ": " + action1_0->get_custom_error());
-            return;
-        }
-        if(!action1->Work_())
+        // Execute actions, form id and columns are independent
+        Tools::ActionGraph graph;
+        graph.AddAsync_(action1_0).AddAsync_(action1);
+        if(!graph.Work_())
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": " + action1->get_custom_error());
+            auto failed = graph.get_failed_identifier() == action1_0->get_identifier() ? action1_0 : action1;
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + failed->get_identifier() + ": " + failed->get_custom_error());
             return;
         }
 
@@ -236,7 +274,7 @@ void Forms::Data::Read_()
 
         // Execute
         action2->set_sql_code(sql_code);
-        if(!action2->Work_())
+        if(!Tools::ReplicaRouter::Read_(action2, id_user, id_space))
         {
             self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error UgOMMObhM2");
             return;
@@ -342,17 +380,16 @@ void Forms::Data::ReadSpecific_()
 
     // Setup Custom Process
     auto id_space = get_space_id();
-    function->SetupCustomProcess_([id_space, action1_0,action1, action2](NAF::Functions::Function& self)
+    auto id_user = get_id_user();
+    function->SetupCustomProcess_([id_space, id_user, action1_0,action1, action2](NAF::Functions::Function& self)
     {
-        // Execute actions
-        if(!action1_0->Work_())
-        {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1_0->get_identifier() + ": " + action1_0->get_custom_error());
-            return;
-        }
-        if(!action1->Work_())
+        // Execute actions, form id and columns are independent
+        Tools::ActionGraph graph;
+        graph.AddAsync_(action1_0).AddAsync_(action1);
+        if(!graph.Work_())
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": " + action1->get_custom_error());
+            auto failed = graph.get_failed_identifier() == action1_0->get_identifier() ? action1_0 : action1;
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + failed->get_identifier() + ": " + failed->get_custom_error());
             return;
         }
 
@@ -402,7 +439,7 @@ void Forms::Data::ReadSpecific_()
 
         // Identify parameters and work
         self.IdentifyParameters_(action2);
-        if(!action2->Work_())
+        if(!Tools::ReplicaRouter::Read_(action2, id_user, id_space))
         {
             self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error 3FqSnoQ4ru");
             return;
@@ -439,7 +476,7 @@ void Forms::Data::ReadFile_()
     function->SetupCustomProcess_([id_space, action1](NAF::Functions::Function& self)
     {
         // Execute actions
-        if(!action1->Work_())
+        if(!Tools::RoutedAction::Prepared_(*action1))
         {
             self.HTMLResponse_(HTTP::Status::kHTTP_NOT_FOUND, "Archivo no encontrado en el formulario actual");
             return;
@@ -467,8 +504,25 @@ void Forms::Data::ReadFile_()
             NAF::Tools::SettingsManager::GetSetting_("directory_for_uploaded_files", "/var/www/structbx-web-uploaded") + "/" + std::string(id_space) + "/" + form_id->ToString_()
         );
 
-        // Download process
+        // Large attachments go from the page cache to the socket
         auto string_path = filepath->get()->ToString_();
+        auto file_manager = self.get_file_manager();
+        auto file = file_manager->CreateTempFile_("/" + string_path);
+        if(file_manager->IsSupported_(file))
+        {
+            auto& request = self.get_http_server_request().value();
+            auto& response = self.get_http_server_response().value();
+            auto path = file_manager->get_directory_base() + "/" + string_path;
+
+            // The response skips NAF, so the cookies queued by BackendServer go on it here
+            for(auto& cookie : self.get_cookies())
+                response->addCookie(cookie.get_cookie());
+            if(Tools::FileSender::Send_(*request, *response, path, file.get_content_type()))
+                return;
+            response->erase("Set-Cookie");
+        }
+
+        // Download process
         self.DownloadProcess_(string_path);
     });
 
@@ -505,7 +559,7 @@ void Forms::Data::Add_()
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": nrjlOllSqm");
             return;
         }
-        if(!action2->Work_())
+        if(!Tools::RoutedAction::Prepared_(*action2))
         {
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2->get_identifier() + ": 9e8LhYKOdu");
             return;
@@ -539,18 +593,19 @@ void Forms::Data::Add_()
 
         // Execute action 3
         self.IdentifyParameters_(action3);
-        if(!action3->Work_())
+        if(!Tools::ShardMap::Prepared_(action3, id_space))
         {
             self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error fECruxvqCZ: No se pudo guardar el registro. " + action3->get_custom_error());
             return;
         }
 
-        // ChangeInt
+        // ChangeInt and total rows
         auto form_identifier = self.GetParameter_("form-identifier");
         if(form_identifier != self.get_parameters().end())
         {
             auto changeInt = ChangeInt();
             changeInt.Change(form_identifier->get()->ToString_(), id_space);
+            Tools::FormCounters::AddTotalRows_(form_identifier->get()->ToString_(), id_space, 1);
         }
 
         // Send results
@@ -560,39 +615,35 @@ void Forms::Data::Add_()
     get_functions()->push_back(function);
 }
 
-void Forms::Data::Modify_()
+void Forms::Data::AddBulk_()
 {
-    // Function GET /api/forms/data/modify
+    // Function POST /api/forms/data/add/bulk
     NAF::Functions::Function::Ptr function = 
-        std::make_shared<NAF::Functions::Function>("/api/forms/data/modify", HTTP::EnumMethods::kHTTP_PUT);
+        std::make_shared<NAF::Functions::Function>("/api/forms/data/add/bulk", HTTP::EnumMethods::kHTTP_POST);
 
     function->set_response_type(NAF::Functions::Function::ResponseType::kCustom);
 
     // Action 1: Verify form existence
     auto action1 = function->AddAction_("a1");
-    actions_.forms_data_.modify_01_.Setup_(action1);
+    actions_.forms_data_.add_01_.Setup_(action1);
 
     // Action 2: Get form columns
     auto action2 = function->AddAction_("a2");
-    actions_.forms_data_.modify_02_.Setup_(action2);
-
-    // Action 3: Update record
-    auto action3 = function->AddAction_("a3");
-    actions_.forms_data_.modify_03_.Setup_(action3);
+    actions_.forms_data_.add_02_.Setup_(action2);
 
     // Setup Custom Process
     auto id_space = get_space_id();
-    function->SetupCustomProcess_([id_space, action1, action2, action3](NAF::Functions::Function& self)
+    function->SetupCustomProcess_([id_space, action1, action2](NAF::Functions::Function& self)
     {
         // Execute actions
-        if(!action1->Work_())
+        if(!Tools::RoutedAction::Prepared_(*action1))
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": CnMsvrA4aa");
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": FvH0sTk2Qe");
             return;
         }
-        if(!action2->Work_())
+        if(!Tools::RoutedAction::Prepared_(*action2))
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2->get_identifier() + ": Fr5MHxX1wQ");
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2->get_identifier() + ": b8WcLr1mXo");
             return;
         }
 
@@ -600,23 +651,88 @@ void Forms::Data::Modify_()
         auto form_id = action1->get_results()->First_();
         if(form_id->IsNull_())
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error PPM2dLq5wk");
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error Zq4nTe7UjA");
             return;
         }
 
-        // Get Column ID
-        auto column_id = action1->get_results()->front()->ExtractField_("column_id");
-        if(column_id->IsNull_())
+        // Get records (JSON array or NDJSON, base64 encoded)
+        auto records_param = self.GetParameter_("records");
+        if(records_param == self.get_parameters().end() || records_param->get()->ToString_() == "")
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error FaAMlFeyJC");
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "No se encontraron registros para guardar");
             return;
         }
+        std::string records_decoded = NAF::Tools::Base64Tool().Decode_(records_param->get()->ToString_());
 
-        // Configure parameters
+        // Parse records
+        std::vector<Poco::JSON::Object::Ptr> records;
+        try
+        {
+            auto first = records_decoded.find_first_not_of(" \t\r\n");
+            if(first != std::string::npos && records_decoded[first] == '[')
+            {
+                Poco::JSON::Parser parser;
+                auto array = parser.parse(records_decoded).extract<Poco::JSON::Array::Ptr>();
+                for(std::size_t i = 0; i < array->size(); i++)
+                    records.push_back(array->getObject(i));
+            }
+            else
+            {
+                std::istringstream stream(records_decoded);
+                std::string line;
+                while(std::getline(stream, line))
+                {
+                    if(line.find_first_not_of(" \t\r") == std::string::npos)
+                        continue;
+                    Poco::JSON::Parser parser;
+                    records.push_back(parser.parse(line).extract<Poco::JSON::Object::Ptr>());
+                }
+            }
+        }
+        catch(std::exception& e)
+        {
+            NAF::Tools::OutputLogger::Debug_(e.what());
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Los registros no tienen un formato JSON v&aacute;lido");
+            return;
+        }
+
+        // Setup columns once for all records
+        std::vector<BulkColumn> bulk_columns;
         std::string columns = "";
         std::string values = "";
-        ParameterConfiguration pc(ParameterConfiguration::Type::kModify, columns, values, id_space);
-        pc.Setup(self, action2->get_results(), form_id, column_id, action3);
+        for(auto it : *action2->get_results())
+        {
+            auto id = it.get()->ExtractField_("id");
+            auto identifier = it.get()->ExtractField_("identifier");
+            auto column_type = it.get()->ExtractField_("column_type");
+            if(identifier->IsNull_() || identifier->ToString_() == "id")
+                continue;
+
+            // Files can't be sent in bulk
+            if(column_type->ToString_() == "image" || column_type->ToString_() == "file")
+                continue;
+
+            bulk_columns.push_back(BulkColumn{
+                identifier->ToString_()
+                ,ParameterVerification(
+                    it.get()->ExtractField_("length")
+                    ,it.get()->ExtractField_("required")
+                    ,it.get()->ExtractField_("default_value")
+                    ,column_type
+                )
+            });
+
+            if(columns == "")
+            {
+                columns = "_structbx_column_" + id->ToString_();
+                values = "?";
+            }
+            else
+            {
+                columns += ",_structbx_column_" + id->ToString_();
+                values += ", ?";
+            }
+        }
 
         // Verify that columns is not empty
         if(columns == "")
@@ -625,79 +741,143 @@ void Forms::Data::Modify_()
             return;
         }
 
-        // Action3: Add id parameter
-        action3->AddParameter_("id", "", true)
-        ->SetupCondition_("condition-id", Query::ConditionType::kError, [](Query::Parameter::Ptr param)
+        // Verify records
+        Poco::JSON::Array::Ptr errors = new Poco::JSON::Array;
+        std::vector<BulkRecord> valid_records;
+        for(std::size_t row = 0; row < records.size(); row++)
         {
-            if(param->get_value()->ToString_() == "")
+            auto& record = records[row];
+            if(record.isNull())
             {
-                param->set_error("El id no puede estar vacío");
+                errors->add(BulkError_(row, "", "El registro debe ser un objeto JSON"));
+                continue;
             }
 
-            return true;
-        });
+            bool valid = true;
+            std::vector<Query::Parameter::Ptr> parameters;
+            for(auto& column : bulk_columns)
+            {
+                NAF::Tools::DValue::Ptr value;
+                if(!BulkValue_(record->get(column.identifier), value))
+                {
+                    errors->add(BulkError_(row, column.identifier, "El valor no es v&aacute;lido"));
+                    valid = false;
+                    break;
+                }
+                auto param = Query::Parameter::Ptr(new Query::Parameter(column.identifier, value, false));
+                if(!column.verification.Verify(param))
+                {
+                    errors->add(BulkError_(row, column.identifier, param->get_error()));
+                    valid = false;
+                    break;
+                }
+                parameters.push_back(param);
+            }
 
-        // Set SQL Code to action 3
-        action3->set_sql_code(
-            "UPDATE _structbx_space_" + id_space + "._structbx_form_" + form_id->ToString_() + " " \
-            "SET " + columns + " WHERE _structbx_column_" + column_id->ToString_() + " = ?");
+            if(valid)
+                valid_records.push_back(std::make_pair(row, parameters));
+        }
 
-        // Execute action 3
-        self.IdentifyParameters_(action3);
-        if(!action3->Work_())
+        // Save records with multi-row INSERTs
+        int batch_size = 500;
+        try
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error UyUKjUef7b: No se pudo guardar el registro.");
-            return;
+            batch_size = std::stoi(NAF::Tools::SettingsManager::GetSetting_("bulk_insert_batch", "500"));
         }
+        catch(std::exception&){NAF::Tools::OutputLogger::Error_("bulk_insert_batch setting is not an integer");}
+        if(batch_size < 1)
+            batch_size = 1;
 
-        // ChangeInt
+        // MySQL takes at most 65535 placeholders per statement
+        batch_size = std::max<int>(1, std::min<int>(batch_size, 65535 / bulk_columns.size()));
+
+        std::string insert_sql = "INSERT INTO _structbx_space_" + id_space + "._structbx_form_" + form_id->ToString_() + " (" + columns + ") VALUES ";
+        auto insert = [&insert_sql, &values, &id_space](std::vector<BulkRecord>::iterator begin, std::vector<BulkRecord>::iterator end)
+        {
+            auto action3 = NAF::Functions::Action("a3");
+            std::string rows_sql = "";
+            for(auto it = begin; it != end; it++)
+            {
+                rows_sql += (rows_sql == "" ? "(" : ", (") + values + ")";
+                for(auto& param : it->second)
+                    action3.AddParameter_(param->get_name(), param->get_value(), false);
+            }
+            action3.set_sql_code(insert_sql + rows_sql);
+            return Tools::ShardMap::Prepared_(action3, id_space);
+        };
+
+        int inserted = 0;
+        for(std::size_t begin = 0; begin < valid_records.size(); begin += batch_size)
+        {
+            auto batch_begin = valid_records.begin() + begin;
+            auto batch_end = valid_records.begin() + std::min(valid_records.size(), begin + batch_size);
+            if(insert(batch_begin, batch_end))
+            {
+                inserted += batch_end - batch_begin;
+                continue;
+            }
+
+            // The batch was rolled back, insert its rows one by one to find the failed ones
+            for(auto it = batch_begin; it != batch_end; it++)
+            {
+                if(insert(it, it + 1))
+                    inserted++;
+                else
+                    errors->add(BulkError_(it->first, "", "No se pudo guardar el registro"));
+            }
+        }
+
+        // ChangeInt and total rows
         auto form_identifier = self.GetParameter_("form-identifier");
-        if(form_identifier != self.get_parameters().end())
+        if(inserted > 0 && form_identifier != self.get_parameters().end())
         {
             auto changeInt = ChangeInt();
             changeInt.Change(form_identifier->get()->ToString_(), id_space);
+            Tools::FormCounters::AddTotalRows_(form_identifier->get()->ToString_(), id_space, inserted);
         }
 
         // Send results
-        self.JSONResponse_(HTTP::Status::kHTTP_OK, "Ok.");
+        Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+        result->set("status", "OK");
+        result->set("message", "Ok.");
+        result->set("total", static_cast<int>(records.size()));
+        result->set("inserted", inserted);
+        result->set("errors", errors);
+        self.CompoundResponse_(HTTP::Status::kHTTP_OK, result);
     });
 
     get_functions()->push_back(function);
 }
 
-void Forms::Data::Delete_()
+void Forms::Data::Import_()
 {
-    // Function GET /api/forms/data/delete
+    // Function POST /api/forms/data/import
     NAF::Functions::Function::Ptr function = 
-        std::make_shared<NAF::Functions::Function>("/api/forms/data/delete", HTTP::EnumMethods::kHTTP_DEL);
+        std::make_shared<NAF::Functions::Function>("/api/forms/data/import", HTTP::EnumMethods::kHTTP_POST);
 
     function->set_response_type(NAF::Functions::Function::ResponseType::kCustom);
 
     // Action 1: Verify form existence
     auto action1 = function->AddAction_("a1");
-    actions_.forms_data_.delete_a01_.Setup_(action1);
-
-    // Action 2_0: Get form columns
-    auto action2_0 = function->AddAction_("a2_0");
-    actions_.forms_data_.add_02_.Setup_(action2_0);
+    actions_.forms_data_.add_01_.Setup_(action1);
 
-    // Action 2: Delete record from table
+    // Action 2: Get form columns
     auto action2 = function->AddAction_("a2");
-    actions_.forms_data_.delete_a02_.Setup_(action2);
+    actions_.forms_data_.add_02_.Setup_(action2);
 
     // Setup Custom Process
     auto id_space = get_space_id();
-    function->SetupCustomProcess_([id_space, action1, action2_0, action2](NAF::Functions::Function& self)
+    function->SetupCustomProcess_([id_space, action1, action2](NAF::Functions::Function& self)
     {
         // Execute actions
-        if(!action1->Work_())
+        if(!Tools::RoutedAction::Prepared_(*action1))
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": twQ1cxcgZs");
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": Kx3vRj8NwA");
             return;
         }
-        if(!action2_0->Work_())
+        if(!Tools::RoutedAction::Prepared_(*action2))
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2_0->get_identifier() + ": PYaZ1nddvm");
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2->get_identifier() + ": p5GdYh2LcE");
             return;
         }
 
@@ -705,119 +885,712 @@ void Forms::Data::Delete_()
         auto form_id = action1->get_results()->First_();
         if(form_id->IsNull_())
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error PPM2dLq5wk");
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error Tm9bQs4ZfU");
             return;
         }
 
-        // Get Column ID
-        auto column_id = action1->get_results()->front()->ExtractField_("column_id");
-        if(column_id->IsNull_())
+        // Get uploaded file
+        auto file_manager = self.get_file_manager();
+        auto found = std::find_if(file_manager->get_files().begin(), file_manager->get_files().end(), [](NAF::Files::File& file)
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error LbunnRyAm2");
+            return file.get_name() == "file";
+        });
+        if(found == file_manager->get_files().end() || found->get_filename() == "")
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "No se encontr&oacute; el archivo a importar");
             return;
         }
 
-        // Delete record files
-        for(auto it : *action2_0->get_results())
+        // Save file to the temp directory, the import reads it from disk without size limit
+        auto import_file_manager = std::make_shared<NAF::Files::FileManager>();
+        import_file_manager->set_operation_type(Files::OperationType::kUpload);
+        import_file_manager->AddSupportedFile_("csv", Files::FileProperties{"text/csv", false, {""}});
+        import_file_manager->AddSupportedFile_("tsv", Files::FileProperties{"text/tab-separated-values", false, {""}});
+        import_file_manager->get_files().push_back(*found);
+        auto& import_file = import_file_manager->get_files().front();
+        if(!import_file_manager->ChangePathAndFilename_(import_file, NAF::Tools::SettingsManager::GetSetting_("directory_for_temp_files", "/tmp")))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error al subir el archivo.");
+            return;
+        }
+        if(!import_file_manager->IsSupported_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Archivo no soportado.");
+            return;
+        }
+        import_file_manager->UploadFile_();
+        auto filepath = import_file.get_requested_file()->path();
+
+        // Delimiter
+        char delimiter = ',';
+        auto delimiter_param = self.GetParameter_("delimiter");
+        if(delimiter_param != self.get_parameters().end() && delimiter_param->get()->ToString_() != "")
+        {
+            auto delimiter_string = delimiter_param->get()->ToString_();
+            delimiter = delimiter_string == "tab" ? '\t' : delimiter_string.front();
+        }
+        else if(filepath.size() > 4 && filepath.substr(filepath.size() - 4) == ".tsv")
+            delimiter = '\t';
+
+        // Setup columns
+        std::vector<Tools::CSVImport::Column> columns;
+        for(auto it : *action2->get_results())
         {
-            // Get column
             auto id = it.get()->ExtractField_("id");
             auto identifier = it.get()->ExtractField_("identifier");
+            auto name = it.get()->ExtractField_("name");
             auto column_type = it.get()->ExtractField_("column_type");
-
-            // Verify identifier is not null
-            if(identifier->IsNull_())
+            if(identifier->IsNull_() || identifier->ToString_() == "id")
                 continue;
 
-            // Verify if is image or file
-            if(column_type->IsNull_())
-                continue;
-            bool r = false;
+            // Files can't be imported
             if(column_type->ToString_() == "image" || column_type->ToString_() == "file")
-                r = true;
-            if(!r)
                 continue;
 
-            // Get file manager
-            auto file_manager = self.get_file_manager();
-            file_manager->set_directory_base(
-                NAF::Tools::SettingsManager::GetSetting_("directory_for_uploaded_files", "/var/www/structbx-web-uploaded") + "/" + std::string(id_space) + "/" + form_id->ToString_()
-            );
-
-            // Request filepath
-            auto action2_2 = self.AddAction_("a2_2");
-            action2_2->set_sql_code(
-                "SELECT _structbx_column_" + id->ToString_() + " "
-                "FROM _structbx_space_" + id_space + "._structbx_form_" + form_id->ToString_() + " " \
-                "WHERE _structbx_column_" + column_id->ToString_() + " = ?"
+            ParameterVerification verification(
+                it.get()->ExtractField_("length")
+                ,it.get()->ExtractField_("required")
+                ,it.get()->ExtractField_("default_value")
+                ,column_type
             );
-            action2_2->AddParameter_("id", "", true)
-            ->SetupCondition_("condition-id", Query::ConditionType::kError, [](Query::Parameter::Ptr param)
-            {
-                if(param->get_value()->ToString_() == "")
+            columns.push_back(Tools::CSVImport::Column{
+                id->ToString_()
+                ,identifier->ToString_()
+                ,name->IsNull_() ? "" : name->ToString_()
+                ,[verification](Query::Parameter::Ptr param) mutable
                 {
-                    param->set_error("El id no puede estar vacío");
+                    return verification.Verify(param);
                 }
-
-                return true;
             });
-            self.IdentifyParameters_(action2_2);
-            if(!action2_2->Work_())
-            {
-                self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2_2->get_identifier() + ": PIvGrSKDYx");
-                return;
-            }
-            auto filepath = action2_2->get_results()->First_();
-
-            // Process file
-            FileProcessing fp;
-            fp.file_manager = file_manager;
-            if(!filepath->IsNull_() && filepath->ToString_() != "")
-            {
-                fp.filepath = filepath->ToString_();
-                fp.Delete();
-            }
         }
 
-        // Action 2: Delete record from table
-        action2->set_sql_code(
-            "DELETE FROM _structbx_space_" + id_space + "._structbx_form_" + form_id->ToString_() + 
-            " WHERE _structbx_column_" + column_id->ToString_() + " = ?"
-        );
-
-        // Execute action 2
-        self.IdentifyParameters_(action2);
-        if(!action2->Work_())
+        // Verify that columns is not empty
+        if(columns.empty())
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error VF1ACrujc7");
+            Poco::File(filepath).remove();
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Debes crear columnas para poder guardar informaci&oacute;n");
             return;
         }
 
-        // ChangeInt
-        auto form_identifier = self.GetParameter_("form-identifier");
-        if(form_identifier != self.get_parameters().end())
+        // Start import
+        auto import = std::make_shared<Tools::CSVImport>(
+            filepath
+            ,"_structbx_space_" + id_space + "._structbx_form_" + form_id->ToString_()
+            ,columns
+            ,delimiter
+        );
+        import->set_space_id(id_space);
+
+        // ChangeInt and total rows once the import finishes
+        auto form_identifier_param = self.GetParameter_("form-identifier");
+        std::string form_identifier = form_identifier_param != self.get_parameters().end() ? form_identifier_param->get()->ToString_() : "";
+        import->set_on_finish([form_identifier, id_space](Tools::CSVImport& import)
         {
-            auto changeInt = ChangeInt();
-            changeInt.Change(form_identifier->get()->ToString_(), id_space);
+            auto inserted = import.Progress_()->getValue<int>("inserted");
+            if(inserted > 0 && form_identifier != "")
+            {
+                auto changeInt = ChangeInt();
+                changeInt.Change(form_identifier, id_space);
+                Tools::FormCounters::AddTotalRows_(form_identifier, id_space, inserted);
+            }
+        });
+        if(!Tools::CSVImport::Start_(import))
+        {
+            Poco::File(filepath).remove();
+            self.get_http_server_response().value()->set("Retry-After", "60");
+            self.JSONResponse_(HTTP::Status::kHTTP_SERVICE_UNAVAILABLE, "Hay demasiadas importaciones en curso, intenta m&aacute;s tarde");
+            return;
         }
 
         // Send results
-        self.JSONResponse_(HTTP::Status::kHTTP_OK, "Ok.");
+        Poco::JSON::Object::Ptr result = new Poco::JSON::Object;
+        result->set("status", "OK");
+        result->set("message", "Ok.");
+        result->set("id", import->get_id());
+        self.CompoundResponse_(HTTP::Status::kHTTP_OK, result);
     });
 
     get_functions()->push_back(function);
 }
 
-bool Forms::Data::ParameterVerification::Verify(Query::Parameter::Ptr param)
+void Forms::Data::ReadImport_()
 {
-    if(param->get_value()->TypeIsIqual_(NAF::Tools::DValue::Type::kEmpty))
+    // Function GET /api/forms/data/import/read
+    NAF::Functions::Function::Ptr function = 
+        std::make_shared<NAF::Functions::Function>("/api/forms/data/import/read", HTTP::EnumMethods::kHTTP_GET);
+
+    function->set_response_type(NAF::Functions::Function::ResponseType::kCustom);
+
+    // Setup Custom Process
+    auto id_space = get_space_id();
+    function->SetupCustomProcess_([id_space](NAF::Functions::Function& self)
     {
-        // If value is empty
-        if(required->Int_() == 1)
+        // Get import
+        auto id = self.GetParameter_("id");
+        if(id == self.get_parameters().end())
         {
-            // If value is required
-            if(default_value->ToString_() == "")
-            {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error Wc6hJr1yPk: El id de importaci&oacute;n no puede estar vac&iacute;o");
+            return;
+        }
+
+        // Imports are only visible from their own space
+        auto import = Tools::CSVImport::Find_(id->get()->ToString_());
+        if(!import || import->get_space_id() != id_space)
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_NOT_FOUND, "La importaci&oacute;n solicitada no existe");
+            return;
+        }
+
+        // Send results
+        auto result = import->Progress_();
+        result->set("status", "OK");
+        result->set("message", "Ok.");
+        self.CompoundResponse_(HTTP::Status::kHTTP_OK, result);
+    });
+
+    get_functions()->push_back(function);
+}
+
+void Forms::Data::Modify_()
+{
+    // Function GET /api/forms/data/modify
+    NAF::Functions::Function::Ptr function = 
+        std::make_shared<NAF::Functions::Function>("/api/forms/data/modify", HTTP::EnumMethods::kHTTP_PUT);
+
+    function->set_response_type(NAF::Functions::Function::ResponseType::kCustom);
+
+    // Action 1: Verify form existence
+    auto action1 = function->AddAction_("a1");
+    actions_.forms_data_.modify_01_.Setup_(action1);
+
+    // Action 2: Get form columns
+    auto action2 = function->AddAction_("a2");
+    actions_.forms_data_.modify_02_.Setup_(action2);
+
+    // Action 3: Update record
+    auto action3 = function->AddAction_("a3");
+    actions_.forms_data_.modify_03_.Setup_(action3);
+
+    // Setup Custom Process
+    auto id_space = get_space_id();
+    function->SetupCustomProcess_([id_space, action1, action2, action3](NAF::Functions::Function& self)
+    {
+        // Execute actions
+        if(!action1->Work_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": CnMsvrA4aa");
+            return;
+        }
+        if(!Tools::RoutedAction::Prepared_(*action2))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2->get_identifier() + ": Fr5MHxX1wQ");
+            return;
+        }
+
+        // Get form ID
+        auto form_id = action1->get_results()->First_();
+        if(form_id->IsNull_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error PPM2dLq5wk");
+            return;
+        }
+
+        // Get Column ID
+        auto column_id = action1->get_results()->front()->ExtractField_("column_id");
+        if(column_id->IsNull_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error FaAMlFeyJC");
+            return;
+        }
+
+        // Configure parameters
+        std::string columns = "";
+        std::string values = "";
+        ParameterConfiguration pc(ParameterConfiguration::Type::kModify, columns, values, id_space);
+        pc.Setup(self, action2->get_results(), form_id, column_id, action3);
+
+        // Verify that columns is not empty
+        if(columns == "")
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Debes crear columnas para poder guardar informaci&oacute;n");
+            return;
+        }
+
+        // Action3: Add id parameter
+        action3->AddParameter_("id", "", true)
+        ->SetupCondition_("condition-id", Query::ConditionType::kError, [](Query::Parameter::Ptr param)
+        {
+            if(param->get_value()->ToString_() == "")
+            {
+                param->set_error("El id no puede estar vacío");
+            }
+
+            return true;
+        });
+
+        // Set SQL Code to action 3
+        action3->set_sql_code(
+            "UPDATE _structbx_space_" + id_space + "._structbx_form_" + form_id->ToString_() + " " \
+            "SET " + columns + " WHERE _structbx_column_" + column_id->ToString_() + " = ?");
+
+        // Execute action 3
+        self.IdentifyParameters_(action3);
+        if(!Tools::ShardMap::Prepared_(action3, id_space))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error UyUKjUef7b: No se pudo guardar el registro.");
+            return;
+        }
+
+        // ChangeInt
+        auto form_identifier = self.GetParameter_("form-identifier");
+        if(form_identifier != self.get_parameters().end())
+        {
+            auto changeInt = ChangeInt();
+            changeInt.Change(form_identifier->get()->ToString_(), id_space);
+        }
+
+        // Send results
+        self.JSONResponse_(HTTP::Status::kHTTP_OK, "Ok.");
+    });
+
+    get_functions()->push_back(function);
+}
+
+void Forms::Data::ModifyBulk_()
+{
+    // Function PUT /api/forms/data/modify/bulk
+    NAF::Functions::Function::Ptr function = 
+        std::make_shared<NAF::Functions::Function>("/api/forms/data/modify/bulk", HTTP::EnumMethods::kHTTP_PUT);
+
+    function->set_response_type(NAF::Functions::Function::ResponseType::kCustom);
+
+    // Action 1: Verify form existence
+    auto action1 = function->AddAction_("a1");
+    actions_.forms_data_.modify_01_.Setup_(action1);
+
+    // Action 2: Get form columns
+    auto action2 = function->AddAction_("a2");
+    actions_.forms_data_.modify_02_.Setup_(action2);
+
+    // Action 3: Update records
+    auto action3 = function->AddAction_("a3");
+    actions_.forms_data_.modify_03_.Setup_(action3);
+
+    // Setup Custom Process
+    auto id_space = get_space_id();
+    function->SetupCustomProcess_([id_space, action1, action2, action3](NAF::Functions::Function& self)
+    {
+        // Execute actions
+        if(!Tools::RoutedAction::Prepared_(*action1))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": Hq2VnYt8sD");
+            return;
+        }
+        if(!Tools::RoutedAction::Prepared_(*action2))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2->get_identifier() + ": m4RkWc9ZpL");
+            return;
+        }
+
+        // Get form ID
+        auto form_id = action1->get_results()->First_();
+        if(form_id->IsNull_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error PPM2dLq5wk");
+            return;
+        }
+
+        // Get Column ID
+        auto column_id = action1->get_results()->front()->ExtractField_("column_id");
+        if(column_id->IsNull_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error Jd7sBx3NqE");
+            return;
+        }
+
+        // Get records to modify
+        std::string selection = "";
+        std::vector<std::string> filter;
+        if(!BulkSelection_(self, form_id->ToString_(), column_id->ToString_(), action2, selection, filter))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Debes enviar los ids o un filtro v&aacute;lido de los registros");
+            return;
+        }
+
+        // Only the columns sent are modified, files can't be modified in bulk
+        std::string columns = "";
+        for(auto it : *action2->get_results())
+        {
+            auto id = it.get()->ExtractField_("id");
+            auto identifier = it.get()->ExtractField_("identifier");
+            auto column_type = it.get()->ExtractField_("column_type");
+            auto length = it.get()->ExtractField_("length");
+            auto required = it.get()->ExtractField_("required");
+            auto default_value = it.get()->ExtractField_("default_value");
+            if(identifier->IsNull_() || identifier->ToString_() == "id")
+                continue;
+            if(column_type->ToString_() == "image" || column_type->ToString_() == "file")
+                continue;
+            if(self.GetParameter_(identifier->ToString_()) == self.get_parameters().end())
+                continue;
+
+            if(columns == "")
+                columns = "_structbx_column_" + id->ToString_() + " = ?";
+            else
+                columns += ",_structbx_column_" + id->ToString_() + " = ?";
+
+            action3->AddParameter_(identifier->ToString_(), NAF::Tools::DValue::Ptr(new NAF::Tools::DValue()), true)
+            ->SetupCondition_(identifier->ToString_(), Query::ConditionType::kError, [length, required, default_value, column_type](Query::Parameter::Ptr param)
+            {
+                ParameterVerification pv(length, required, default_value, column_type);
+                return pv.Verify(param);
+            });
+        }
+
+        // Verify that columns is not empty
+        if(columns == "")
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Debes enviar al menos una columna para modificar");
+            return;
+        }
+
+        // Filter values go after the SET values
+        for(auto& value : filter)
+            action3->AddParameter_("filter", value, false);
+
+        // Set SQL Code to action 3, a single UPDATE for all the selected records
+        action3->set_sql_code(
+            "UPDATE _structbx_space_" + id_space + "._structbx_form_" + form_id->ToString_() + " AS _" + form_id->ToString_() + " " \
+            "SET " + columns + " WHERE " + selection);
+
+        // Execute action 3
+        self.IdentifyParameters_(action3);
+        if(!Tools::ShardMap::Prepared_(action3, id_space))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error Ue5cTn0WgR: No se pudieron guardar los registros. " + action3->get_custom_error());
+            return;
+        }
+
+        // ChangeInt
+        auto form_identifier = self.GetParameter_("form-identifier");
+        if(form_identifier != self.get_parameters().end())
+        {
+            auto changeInt = ChangeInt();
+            changeInt.Change(form_identifier->get()->ToString_(), id_space);
+        }
+
+        // Send results
+        self.JSONResponse_(HTTP::Status::kHTTP_OK, "Ok.");
+    });
+
+    get_functions()->push_back(function);
+}
+
+void Forms::Data::Delete_()
+{
+    // Function GET /api/forms/data/delete
+    NAF::Functions::Function::Ptr function = 
+        std::make_shared<NAF::Functions::Function>("/api/forms/data/delete", HTTP::EnumMethods::kHTTP_DEL);
+
+    function->set_response_type(NAF::Functions::Function::ResponseType::kCustom);
+
+    // Action 1: Verify form existence
+    auto action1 = function->AddAction_("a1");
+    actions_.forms_data_.delete_a01_.Setup_(action1);
+
+    // Action 2_0: Get form columns
+    auto action2_0 = function->AddAction_("a2_0");
+    actions_.forms_data_.add_02_.Setup_(action2_0);
+
+    // Action 2: Delete record from table
+    auto action2 = function->AddAction_("a2");
+    actions_.forms_data_.delete_a02_.Setup_(action2);
+
+    // Setup Custom Process
+    auto id_space = get_space_id();
+    function->SetupCustomProcess_([id_space, action1, action2_0, action2](NAF::Functions::Function& self)
+    {
+        // Execute actions
+        if(!action1->Work_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": twQ1cxcgZs");
+            return;
+        }
+        if(!Tools::RoutedAction::Prepared_(*action2_0))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2_0->get_identifier() + ": PYaZ1nddvm");
+            return;
+        }
+
+        // Get form ID
+        auto form_id = action1->get_results()->First_();
+        if(form_id->IsNull_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error PPM2dLq5wk");
+            return;
+        }
+
+        // Get Column ID
+        auto column_id = action1->get_results()->front()->ExtractField_("column_id");
+        if(column_id->IsNull_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error LbunnRyAm2");
+            return;
+        }
+
+        // Delete record files
+        for(auto it : *action2_0->get_results())
+        {
+            // Get column
+            auto id = it.get()->ExtractField_("id");
+            auto identifier = it.get()->ExtractField_("identifier");
+            auto column_type = it.get()->ExtractField_("column_type");
+
+            // Verify identifier is not null
+            if(identifier->IsNull_())
+                continue;
+
+            // Verify if is image or file
+            if(column_type->IsNull_())
+                continue;
+            bool r = false;
+            if(column_type->ToString_() == "image" || column_type->ToString_() == "file")
+                r = true;
+            if(!r)
+                continue;
+
+            // Get file manager
+            auto file_manager = self.get_file_manager();
+            file_manager->set_directory_base(
+                NAF::Tools::SettingsManager::GetSetting_("directory_for_uploaded_files", "/var/www/structbx-web-uploaded") + "/" + std::string(id_space) + "/" + form_id->ToString_()
+            );
+
+            // Request filepath
+            auto action2_2 = self.AddAction_("a2_2");
+            action2_2->set_sql_code(
+                "SELECT _structbx_column_" + id->ToString_() + " "
+                "FROM _structbx_space_" + id_space + "._structbx_form_" + form_id->ToString_() + " " \
+                "WHERE _structbx_column_" + column_id->ToString_() + " = ?"
+            );
+            action2_2->AddParameter_("id", "", true)
+            ->SetupCondition_("condition-id", Query::ConditionType::kError, [](Query::Parameter::Ptr param)
+            {
+                if(param->get_value()->ToString_() == "")
+                {
+                    param->set_error("El id no puede estar vacío");
+                }
+
+                return true;
+            });
+            self.IdentifyParameters_(action2_2);
+            if(!Tools::ShardMap::Prepared_(action2_2, id_space))
+            {
+                self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2_2->get_identifier() + ": PIvGrSKDYx");
+                return;
+            }
+            auto filepath = action2_2->get_results()->First_();
+
+            // Process file
+            FileProcessing fp;
+            fp.file_manager = file_manager;
+            fp.space_id = id_space;
+            fp.form_id = form_id->ToString_();
+            if(!filepath->IsNull_() && filepath->ToString_() != "")
+            {
+                fp.filepath = filepath->ToString_();
+                fp.Delete();
+            }
+        }
+
+        // Action 2: Delete record from table
+        action2->set_sql_code(
+            "DELETE FROM _structbx_space_" + id_space + "._structbx_form_" + form_id->ToString_() + 
+            " WHERE _structbx_column_" + column_id->ToString_() + " = ?"
+        );
+
+        // Execute action 2
+        self.IdentifyParameters_(action2);
+        Tools::ActionChain chain(Tools::ShardMap::Locate_(id_space));
+        chain.Add_(action2);
+        if(!chain.Work_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error VF1ACrujc7");
+            return;
+        }
+        auto deleted = chain.get_affected_rows(action2->get_identifier());
+
+        // ChangeInt and total rows
+        auto form_identifier = self.GetParameter_("form-identifier");
+        if(form_identifier != self.get_parameters().end())
+        {
+            auto changeInt = ChangeInt();
+            changeInt.Change(form_identifier->get()->ToString_(), id_space);
+            Tools::FormCounters::AddTotalRows_(form_identifier->get()->ToString_(), id_space, -deleted);
+        }
+
+        // Send results
+        self.JSONResponse_(HTTP::Status::kHTTP_OK, "Ok.");
+    });
+
+    get_functions()->push_back(function);
+}
+
+void Forms::Data::DeleteBulk_()
+{
+    // Function DEL /api/forms/data/delete/bulk
+    NAF::Functions::Function::Ptr function = 
+        std::make_shared<NAF::Functions::Function>("/api/forms/data/delete/bulk", HTTP::EnumMethods::kHTTP_DEL);
+
+    function->set_response_type(NAF::Functions::Function::ResponseType::kCustom);
+
+    // Action 1: Verify form existence
+    auto action1 = function->AddAction_("a1");
+    actions_.forms_data_.delete_a01_.Setup_(action1);
+
+    // Action 2_0: Get form columns
+    auto action2_0 = function->AddAction_("a2_0");
+    actions_.forms_data_.add_02_.Setup_(action2_0);
+
+    // Setup Custom Process
+    auto id_space = get_space_id();
+    function->SetupCustomProcess_([id_space, action1, action2_0](NAF::Functions::Function& self)
+    {
+        // Execute actions
+        if(!Tools::RoutedAction::Prepared_(*action1))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": Rb8yLm2VxK");
+            return;
+        }
+        if(!Tools::RoutedAction::Prepared_(*action2_0))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2_0->get_identifier() + ": Gw3PzQ6hTf");
+            return;
+        }
+
+        // Get form ID
+        auto form_id = action1->get_results()->First_();
+        if(form_id->IsNull_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error PPM2dLq5wk");
+            return;
+        }
+
+        // Get Column ID
+        auto column_id = action1->get_results()->front()->ExtractField_("column_id");
+        if(column_id->IsNull_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error Nc1kXs7YbM");
+            return;
+        }
+
+        // Get records to delete
+        std::string selection = "";
+        std::vector<std::string> filter;
+        if(!BulkSelection_(self, form_id->ToString_(), column_id->ToString_(), action2_0, selection, filter))
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Debes enviar los ids o un filtro v&aacute;lido de los registros");
+            return;
+        }
+        std::string table = "_structbx_space_" + id_space + "._structbx_form_" + form_id->ToString_() + " AS _" + form_id->ToString_();
+
+        // Get file columns
+        std::string file_columns = "";
+        for(auto it : *action2_0->get_results())
+        {
+            auto id = it.get()->ExtractField_("id");
+            auto identifier = it.get()->ExtractField_("identifier");
+            auto column_type = it.get()->ExtractField_("column_type");
+            if(identifier->IsNull_() || column_type->IsNull_())
+                continue;
+            if(column_type->ToString_() != "image" && column_type->ToString_() != "file")
+                continue;
+
+            if(file_columns == "")
+                file_columns = "_structbx_column_" + id->ToString_();
+            else
+                file_columns += ", _structbx_column_" + id->ToString_();
+        }
+
+        // Every filepath with one query and the records with one statement, in the
+        // same transaction so the files read are the ones of the deleted records
+        Tools::ActionChain chain(Tools::ShardMap::Locate_(id_space));
+        NAF::Functions::Action::Ptr action2_2;
+        if(file_columns != "")
+        {
+            action2_2 = self.AddAction_("a2_2");
+            action2_2->set_sql_code("SELECT " + file_columns + " FROM " + table + " WHERE " + selection + " FOR UPDATE");
+            for(auto& value : filter)
+                action2_2->AddParameter_("filter", value, false);
+            chain.Add_(action2_2);
+        }
+
+        // Action 2: Delete records from table
+        auto action2 = self.AddAction_("a2");
+        action2->set_sql_code("DELETE _" + form_id->ToString_() + " FROM " + table + " WHERE " + selection);
+        for(auto& value : filter)
+            action2->AddParameter_("filter", value, false);
+        chain.Add_(action2);
+        if(!chain.Work_())
+        {
+            self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error Qp9vDs2JxA");
+            return;
+        }
+        auto deleted = chain.get_affected_rows(action2->get_identifier());
+
+        std::vector<std::string> filepaths;
+        if(action2_2)
+        {
+            for(auto row : *action2_2->get_results())
+            {
+                for(auto field : *row)
+                {
+                    if(!field->IsNull_() && field->ToString_() != "")
+                        filepaths.push_back(field->ToString_());
+                }
+            }
+        }
+
+        // Delete record files once the records are gone
+        auto file_manager = self.get_file_manager();
+        file_manager->set_directory_base(
+            NAF::Tools::SettingsManager::GetSetting_("directory_for_uploaded_files", "/var/www/structbx-web-uploaded") + "/" + std::string(id_space) + "/" + form_id->ToString_()
+        );
+        for(auto& filepath : filepaths)
+        {
+            FileProcessing fp;
+            fp.file_manager = file_manager;
+            fp.space_id = id_space;
+            fp.form_id = form_id->ToString_();
+            fp.filepath = filepath;
+            fp.Delete();
+        }
+
+        // ChangeInt and total rows
+        auto form_identifier = self.GetParameter_("form-identifier");
+        if(form_identifier != self.get_parameters().end())
+        {
+            auto changeInt = ChangeInt();
+            changeInt.Change(form_identifier->get()->ToString_(), id_space);
+            Tools::FormCounters::AddTotalRows_(form_identifier->get()->ToString_(), id_space, -deleted);
+        }
+
+        // Send results
+        self.JSONResponse_(HTTP::Status::kHTTP_OK, "Ok.");
+    });
+
+    get_functions()->push_back(function);
+}
+
+bool Forms::Data::ParameterVerification::Verify(Query::Parameter::Ptr param)
+{
+    if(param->get_value()->TypeIsIqual_(NAF::Tools::DValue::Type::kEmpty))
+    {
+        // If value is empty
+        if(required->Int_() == 1)
+        {
+            // If value is required
+            if(default_value->ToString_() == "")
+            {
                 // default value is empty
                 param->set_error("Este parámetro es obligatorio");
                 return false;
@@ -907,6 +1680,8 @@ void Forms::Data::ParameterConfiguration::Setup(NAF::Functions::Function& self,
             // Process file
             FileProcessing fp;
             fp.file_manager = new_file_manager;
+            fp.space_id = id_space;
+            fp.form_id = form_id->ToString_();
 
             // Setup columns and values string
             std::string filepath_string = "";
@@ -953,7 +1728,7 @@ void Forms::Data::ParameterConfiguration::Setup(NAF::Functions::Function& self,
                     return true;
                 });
                 self.IdentifyParameters_(action2_1);
-                if(!action2_1->Work_())
+                if(!Tools::ShardMap::Prepared_(action2_1, id_space))
                 {
                     self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2_1->get_identifier() + ": yKqkgKKfdg");
                     return;
@@ -1063,43 +1838,151 @@ bool Forms::Data::FileProcessing::Save()
         error = "El archivo debe ser de menos de 5MB.";
         return false;
     }
-    file_manager->UploadFile_();
+    // Storage accounting, the bytes are reserved before the upload and given back if it fails
+    long long reserved = front_file.get_content_length();
+    if(!Tools::StorageAccounting::Reserve_(space_id, form_id, reserved))
+    {
+        error = "El espacio no tiene almacenamiento disponible.";
+        return false;
+    }
+    try
+    {
+        file_manager->UploadFile_();
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Error_("FileProcessing: " + std::string(e.what()));
+        Tools::StorageAccounting::AddBytes_(space_id, form_id, -reserved);
+        error = "Error al subir el archivo.";
+        return false;
+    }
     
     filepath = front_file.get_requested_path()->getFileName();
+
+    // The size on disk may differ from the declared one
+    try
+    {
+        long long size = Poco::File(front_file.get_requested_file()->path()).getSize();
+        Tools::StorageAccounting::AddBytes_(space_id, form_id, size - reserved);
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Error_("FileProcessing: " + std::string(e.what()));
+    }
+
     return true; 
 }
 
 bool Forms::Data::FileProcessing::Delete()
 {
-    // Verify logo exists and remove it
-    Files::FileManager file_manager;
-    file_manager.set_directory_base(this->file_manager->get_directory_base());
-    file_manager.set_operation_type(Files::OperationType::kDelete);
-    file_manager.get_files().push_back(file_manager.CreateTempFile_("/" + filepath));
-
-    if(file_manager.CheckFiles_())
+    // Storage accounting
+    auto path = file_manager->get_directory_base() + "/" + filepath;
+    try
+    {
+        Poco::File file(path);
+        if(filepath != "" && file.exists())
+            Tools::StorageAccounting::AddBytes_(space_id, form_id, -static_cast<long long>(file.getSize()));
+    }
+    catch(std::exception& e)
     {
-        file_manager.RemoveFile_();
+        NAF::Tools::OutputLogger::Error_("FileProcessing: " + std::string(e.what()));
     }
-    else
+
+    // Removed in background by FileCleanupQueue
+    if(filepath == "" || !Tools::FileCleanupQueue::Enqueue_(path))
+    {
+        error = "No se pudo borrar el archivo.";
         return false;
+    }
     
     return true;
 }
 
-void Forms::Data::ChangeInt::Change(std::string form_identifier, std::string space_id)
+bool Forms::Data::BulkValue_(Poco::Dynamic::Var value, NAF::Tools::DValue::Ptr& result)
 {
-    // Action 1: Get Change int
-    auto action1 = NAF::Functions::Action("a1");
-    action1.set_sql_code(
-        "UPDATE forms "
-        "SET change_int = change_int + 1 "
-        "WHERE identifier = ? AND id_space = ?"
-    );
+    // Integers beyond int and decimals go as text, MySQL converts them without narrowing
+    try
+    {
+        if(value.isEmpty())
+            result = NAF::Tools::DValue::Ptr(new NAF::Tools::DValue());
+        else if(value.isBoolean())
+            result = NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(value.convert<bool>() ? 1 : 0));
+        else if(value.isInteger())
+        {
+            bool fits = value.isSigned()
+                ? value.convert<Poco::Int64>() >= std::numeric_limits<int>::min() && value.convert<Poco::Int64>() <= std::numeric_limits<int>::max()
+                : value.convert<Poco::UInt64>() <= static_cast<Poco::UInt64>(std::numeric_limits<int>::max());
+            if(fits)
+                result = NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(static_cast<int>(value.convert<Poco::Int64>())));
+            else
+                result = NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(value.convert<std::string>()));
+        }
+        else if(value.isNumeric())
+            result = NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(Poco::NumberFormatter::format(value.convert<double>(), 17)));
+        else
+            result = NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(value.convert<std::string>()));
+    }
+    catch(std::exception&)
+    {
+        return false;
+    }
+
+    return true;
+}
 
-    action1.AddParameter_("form-identifier", form_identifier, false);
-    action1.AddParameter_("id_space", space_id, false);
+Poco::JSON::Object::Ptr Forms::Data::BulkError_(std::size_t row, std::string column, std::string error)
+{
+    Poco::JSON::Object::Ptr row_error = new Poco::JSON::Object;
+    row_error->set("row", static_cast<int>(row));
+    row_error->set("column", column);
+    row_error->set("error", error);
+    return row_error;
+}
+
+bool Forms::Data::BulkSelection_(NAF::Functions::Function& self, std::string form_id, std::string column_id, NAF::Functions::Action::Ptr columns, std::string& selection, std::vector<std::string>& filter)
+{
+    // Ids list: 1,2,3
+    auto ids = self.GetParameter_("ids");
+    if(ids != self.get_parameters().end() && ids->get()->ToString_() != "")
+    {
+        auto ids_string = ids->get()->ToString_();
+        if(!Tools::IDChecker().CheckNumbers_(ids_string) || ids_string.front() == ',' || ids_string.back() == ',' || ids_string.find(",,") != std::string::npos)
+            return false;
+
+        selection = "_" + form_id + "._structbx_column_" + column_id + " IN (" + ids_string + ")";
+    }
 
-    // Execute action
-    action1.Work_();
+    // Filter: filter-<column identifier>=value for each column, the values are bound
+    // to placeholders, never SQL conditions from the client
+    for(auto& param : self.get_parameters())
+    {
+        auto name = param->get_name();
+        if(name.compare(0, 7, "filter-") != 0)
+            continue;
+
+        std::string column = "";
+        for(auto row : *columns->get_results())
+        {
+            auto id = row->ExtractField_("id");
+            auto identifier = row->ExtractField_("identifier");
+            if(!id->IsNull_() && !identifier->IsNull_() && identifier->ToString_() == name.substr(7))
+            {
+                column = "_" + form_id + "._structbx_column_" + id->ToString_();
+                break;
+            }
+        }
+        if(column == "")
+            return false;
+
+        selection += std::string(selection == "" ? "" : " AND ") + column + " = ?";
+        filter.push_back(param->get_value()->ToString_());
+    }
+
+    return selection != "";
+}
+
+void Forms::Data::ChangeInt::Change(std::string form_identifier, std::string space_id)
+{
+    // Increment in memory, FormCounters writes it to the forms table in batches
+    Tools::FormCounters::IncrementChangeInt_(form_identifier, space_id);
 }
@@ -2,10 +2,24 @@
 #ifndef STRUCTBX_FUNCTIONS_FORMS_DATA_H
 #define STRUCTBX_FUNCTIONS_FORMS_DATA_H
 
+#include <limits>
 #include <fstream>
+#include <sstream>
+
+#include "Poco/JSON/Parser.h"
+#include "Poco/NumberFormatter.h"
 
 #include "tools/function_data.h"
 #include "tools/actions_data.h"
+#include "tools/form_counters.h"
+#include "tools/csv_import.h"
+#include "tools/file_cleanup_queue.h"
+#include "tools/action_graph.h"
+#include "tools/action_chain.h"
+#include "tools/storage_accounting.h"
+#include "tools/shard_map.h"
+#include "tools/replica_router.h"
+#include "tools/file_sender.h"
 #include <functions/action.h>
 #include <functions/function.h>
 #include <query/field.h>
@@ -54,6 +68,8 @@ class StructBX::Functions::Forms::Data : public Tools::FunctionData
             bool Delete();
 
             NAF::Files::FileManager::Ptr file_manager;
+            std::string space_id = "";
+            std::string form_id = "";
             std::string filepath = "";
             std::string name = "";
             std::string error = "";
@@ -84,14 +100,29 @@ class StructBX::Functions::Forms::Data : public Tools::FunctionData
         {
             void Change(std::string form_identifier, std::string space_id);
         };
+        struct BulkColumn
+        {
+            std::string identifier;
+            ParameterVerification verification;
+        };
+        using BulkRecord = std::pair<std::size_t, std::vector<Query::Parameter::Ptr>>;
+
+        static bool BulkValue_(Poco::Dynamic::Var value, NAF::Tools::DValue::Ptr& result);
+        static Poco::JSON::Object::Ptr BulkError_(std::size_t row, std::string column, std::string error);
+        static bool BulkSelection_(NAF::Functions::Function& self, std::string form_id, std::string column_id, NAF::Functions::Action::Ptr columns, std::string& selection, std::vector<std::string>& filter);
 
         void ReadChangeInt_();
         void Read_();
         void ReadSpecific_();
         void ReadFile_();
         void Add_();
+        void AddBulk_();
+        void Import_();
+        void ReadImport_();
         void Modify_();
+        void ModifyBulk_();
         void Delete_();
+        void DeleteBulk_();
 
     private:
         Tools::ActionsData actions_;
@@ -38,32 +38,50 @@ void Main::Read_()
             return;
         }
 
-        // Iterate over results
-        for(auto row : *action1->get_results())
+        // InnoDB estimates of the space database, on its shard if it has one
+        bool estimated = Tools::FormCounters::UseEstimatedTotalRows_();
+        std::map<std::string, int> estimates;
+        if(estimated)
         {
-            // Get form id
-            auto id = row->ExtractField_("id");
-            if(id->IsNull_())
-                continue;
-
-            // Action 2: COUNT
             auto action2 = NAF::Functions::Action("a2");
             action2.set_sql_code(
-                "SELECT COUNT(1) AS total " \
-                "FROM _structbx_space_" + space_id + "._structbx_form_" + id.get()->ToString_());
-            if(!action2.Work_())
+                "SELECT TABLE_NAME AS name, IFNULL(TABLE_ROWS, 0) AS total " \
+                "FROM information_schema.TABLES " \
+                "WHERE TABLE_SCHEMA = ?"
+            );
+            action2.AddParameter_("schema", "_structbx_space_" + space_id, false);
+            if(Tools::ShardMap::Prepared_(action2, space_id))
             {
-                self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error JNt2Std2sh");
-                return;
+                for(auto row : *action2.get_results())
+                {
+                    auto name = row->ExtractField_("name");
+                    auto total = row->ExtractField_("total");
+                    if(!name->IsNull_() && !total->IsNull_())
+                        estimates[name->ToString_()] = total->Int_();
+                }
             }
+        }
 
-            // Get results
-            auto total = action2.get_results()->First_();
-            if(total->IsNull_())
+        // Add the rows not flushed yet to the stored totals
+        for(auto row : *action1->get_results())
+        {
+            auto id = row->ExtractField_("id");
+            auto identifier = row->ExtractField_("identifier");
+            auto stored_total = row->ExtractField_("stored_total");
+            if(id->IsNull_() || identifier->IsNull_() || stored_total->IsNull_())
                 continue;
 
-            row->AddField_("total", NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(total->Int_())));
+            int total = 0;
+            if(estimated)
+            {
+                auto found = estimates.find("_structbx_form_" + id->ToString_());
+                if(found != estimates.end())
+                    total = found->second;
+            }
+            else
+                total = stored_total->Int_() + Tools::FormCounters::PendingTotalRows_(identifier->ToString_(), space_id);
 
+            row->AddField_("total", NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(total)));
         }
 
         // JSON Results
@@ -130,19 +148,18 @@ void Main::Add_()
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": " + action1->get_custom_error());
             return;
         }
-        if(!action2->Work_())
-        {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2->get_identifier() + ": " + action2->get_custom_error());
-            return;
-        }
-        if(!action3->Work_())
+
+        // Action 2 and 3: Add the form and its ID column in one transaction
+        Tools::ActionChain chain;
+        chain.Add_(action2).Add_(action3);
+        if(!chain.Work_())
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action3->get_identifier() + ": " + action3->get_custom_error());
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + chain.get_failed_identifier() + ": " + chain.get_error());
             return;
         }
 
         // Form ID
-        int form_id = action2->get_last_insert_id();
+        int form_id = chain.get_last_insert_id(action2->get_identifier());
         if(form_id == 0)
         {
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error MVm2IlbSnm");
@@ -150,28 +167,33 @@ void Main::Add_()
         }
 
         // Columns ID
-        int column_id = action3->get_last_insert_id();
+        int column_id = chain.get_last_insert_id(action3->get_identifier());
         if(column_id == 0)
         {
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error lyEC9cs1tj");
             return;
         }
 
-        // Action 4: Create the table
+        // Action 4: Create the table (DDL commits implicitly, so it runs after the transaction)
         action4->set_sql_code(
             "CREATE TABLE _structbx_space_" + space_id + "._structbx_form_" + std::to_string(form_id) + " " \
             "(" \
                 "_structbx_column_" + std::to_string(column_id) + " INT NOT NULL AUTO_INCREMENT PRIMARY KEY " \
             ")"
         );
-        if(!action4->Work_())
+        if(!Tools::ShardMap::Work_(action4, space_id))
         {
             self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error " + action4->get_identifier() + ": No se pudo crear la tabla");
 
-            // Delete form from table
+            // Delete form and its columns from tables
             NAF::Functions::Action action5("a5");
-            action5.set_sql_code("DELETE FROM forms WHERE id = ?");
+            action5.set_sql_code("DELETE FROM forms_columns WHERE id_form = ?");
             action5.AddParameter_("id", std::to_string(form_id), false);
+            NAF::Functions::Action action6("a6");
+            action6.set_sql_code("DELETE FROM forms WHERE id = ?");
+            action6.AddParameter_("id", std::to_string(form_id), false);
+            if(!chain.Compensate_(action5) || !chain.Compensate_(action6))
+                NAF::Tools::OutputLogger::Error_("Forms::Main::Add_: Could not delete form " + std::to_string(form_id));
 
             return;
         }
@@ -274,7 +296,7 @@ void Main::Delete_()
         // Action 3: Drop table
         auto action3 = self.AddAction_("a3");
         action3->set_sql_code("DROP TABLE IF EXISTS _structbx_space_" + space_id + "._structbx_form_" + id->get()->ToString_());
-        if(!action3->Work_())
+        if(!Tools::ShardMap::Work_(action3, space_id))
         {
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error lOuU13kOu6, asegúrese que no hayan enlaces creados hacia su formulario");
             return;
@@ -288,31 +310,14 @@ void Main::Delete_()
             return;
         }
 
-        // Delete form directory
-        try
-        {
-            auto directory = NAF::Tools::SettingsManager::GetSetting_("directory_for_uploaded_files", "/var/www/structbx-web-uploaded");
-            directory += "/" + space_id + "/" + id->get()->ToString_();
-            Poco::File file(directory);
-            if(file.exists())
-            {
-                self.JSONResponse_(HTTP::Status::kHTTP_OK, "Ok.");
-                return;
-            }
-            file.remove(true);
+        // Storage accounting
+        Tools::StorageAccounting::AddBytes_(space_id, id->get()->ToString_(), -Tools::StorageAccounting::FormBytes_(space_id, id->get()->ToString_()));
 
-            // Send results
-            self.JSONResponse_(HTTP::Status::kHTTP_OK, "Ok.");
-        }
-        catch(Poco::FileException& e)
+        // Delete form directory in background
+        auto directory = NAF::Tools::SettingsManager::GetSetting_("directory_for_uploaded_files", "/var/www/structbx-web-uploaded");
+        directory += "/" + space_id + "/" + id->get()->ToString_();
+        if(!Tools::FileCleanupQueue::Enqueue_(directory, true))
         {
-            NAF::Tools::OutputLogger::Debug_(e.displayText());
-            self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error: No se pudo borrar el directorio de archivos del formulario");
-            return;
-        }
-        catch(std::exception& e)
-        {
-            NAF::Tools::OutputLogger::Debug_(e.what());
             self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error: No se pudo borrar el directorio de archivos del formulario");
             return;
         }
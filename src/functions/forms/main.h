@@ -4,6 +4,8 @@
 
 #include "tools/function_data.h"
 #include "tools/actions_data.h"
+#include "tools/action_chain.h"
+#include "tools/shard_map.h"
 
 #include "functions/forms/data.h"
 #include "functions/forms/columns.h"
@@ -8,6 +8,7 @@ Groups::Groups(Tools::FunctionData& function_data) :
     ,actions_(function_data)
 {
     Read_();
+    ReloadPermissions_();
 }
 
 void Groups::Read_()
@@ -24,3 +25,23 @@ void Groups::Read_()
 
     get_functions()->push_back(function);
 }
+
+void Groups::ReloadPermissions_()
+{
+    // Function POST /api/organizations/groups/permissions/reload
+    NAF::Functions::Function::Ptr function = 
+        std::make_shared<NAF::Functions::Function>("/api/organizations/groups/permissions/reload", HTTP::EnumMethods::kHTTP_POST);
+    
+    function->set_response_type(NAF::Functions::Function::ResponseType::kCustom);
+
+    // Setup custom process, the compiled table is swapped without a restart
+    function->SetupCustomProcess_([](NAF::Functions::Function& self)
+    {
+        Tools::PermissionsTable::Reload_();
+
+        // Send results
+        self.JSONResponse_(HTTP::Status::kHTTP_OK, "Ok");
+    });
+
+    get_functions()->push_back(function);
+}
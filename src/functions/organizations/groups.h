@@ -5,6 +5,7 @@
 
 #include "tools/function_data.h"
 #include "tools/actions_data.h"
+#include "tools/permissions_table.h"
 
 namespace StructBX
 {
@@ -27,6 +28,7 @@ class StructBX::Functions::Organizations::Groups : public Tools::FunctionData
         
     protected:
         void Read_();
+        void ReloadPermissions_();
 
     private:
         Tools::ActionsData actions_;
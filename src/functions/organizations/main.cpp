@@ -12,6 +12,7 @@ Main::Main(Tools::FunctionData& function_data) :
 {
     Read_();
     Modify_();
+    ReadMetrics_();
 }
 
 void Main::Read_()
@@ -64,3 +65,27 @@ void Main::Modify_()
     
     get_functions()->push_back(function);
 }
+
+void Main::ReadMetrics_()
+{
+    // Function GET /api/organizations/metrics/read
+    NAF::Functions::Function::Ptr function = 
+        std::make_shared<NAF::Functions::Function>("/api/organizations/metrics/read", HTTP::EnumMethods::kHTTP_GET);
+    
+    function->set_response_type(NAF::Functions::Function::ResponseType::kCustom);
+
+    // Setup custom process, load of the server and its database connections
+    function->SetupCustomProcess_([](NAF::Functions::Function& self)
+    {
+        Poco::JSON::Object::Ptr results = new Poco::JSON::Object;
+        results->set("connection_pool", Tools::ConnectionPool::Metrics_());
+        results->set("statement_cache", Tools::StatementCache::Metrics_());
+        results->set("admission", Tools::AdmissionControl::Metrics_());
+        results->set("space_scheduler", Tools::SpaceScheduler::Metrics_());
+
+        // Send results
+        self.CompoundResponse_(HTTP::Status::kHTTP_OK, results);
+    });
+
+    get_functions()->push_back(function);
+}
@@ -8,6 +8,9 @@
 
 #include "functions/organizations/users.h"
 #include "functions/organizations/groups.h"
+#include "tools/connection_pool.h"
+#include "tools/admission_control.h"
+#include "tools/space_scheduler.h"
 
 namespace StructBX
 {
@@ -31,6 +34,7 @@ class StructBX::Functions::Organizations::Main : public Tools::FunctionData
     protected:
         void Read_();
         void Modify_();
+        void ReadMetrics_();
 
     private:
         Tools::ActionsData actions_;
@@ -13,6 +13,7 @@ Users::Users(Tools::FunctionData& function_data) :
     ReadSpecific_();
     ModifyCurrentUsername_();
     ModifyCurrentPassword_();
+    RevokeCurrentTokens_();
     Add_();
     Modify_();
     Delete_();
@@ -30,9 +31,9 @@ void Users::Read_()
         "FROM _naf_users nu "
         "JOIN _naf_groups ng ON ng.id = nu.id_group "
         "JOIN organizations_users ou ON ou.id_naf_user = nu.id "
-        "WHERE ou.id_organization = (SELECT id_organization FROM organizations_users WHERE id_naf_user = ?)"
+        "WHERE ou.id_organization = ?"
     );
-    action1->AddParameter_("id_user", get_id_user(), false);
+    action1->AddParameter_("id_organization", get_organization_id(), false);
 
     get_functions()->push_back(function);
 }
@@ -154,6 +155,33 @@ void Users::ModifyCurrentPassword_()
     get_functions()->push_back(function);
 }
 
+void Users::RevokeCurrentTokens_()
+{
+    // Function POST /api/organizations/users/current/tokens/revoke
+    NAF::Functions::Function::Ptr function = 
+        std::make_shared<NAF::Functions::Function>("/api/organizations/users/current/tokens/revoke", HTTP::EnumMethods::kHTTP_POST);
+    
+    function->set_response_type(NAF::Functions::Function::ResponseType::kCustom);
+
+    // Setup custom process, /api/system/logout revokes them as well
+    auto current_user = get_id_user();
+    function->SetupCustomProcess_([current_user](NAF::Functions::Function& self)
+    {
+        Tools::SessionToken::RevokeUser_(current_user);
+        Tools::SessionStore::EraseUser_(current_user);
+
+        Net::HTTPCookie cookie(Tools::SessionToken::CookieName_(), "");
+        cookie.setPath("/");
+        cookie.setMaxAge(0);
+        self.get_http_server_response().value()->addCookie(cookie);
+
+        // Send results
+        self.JSONResponse_(HTTP::Status::kHTTP_OK, "Ok");
+    });
+
+    get_functions()->push_back(function);
+}
+
 void Users::Add_()
 {
     // Function GET /api/organizations/users/add
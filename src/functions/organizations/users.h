@@ -5,6 +5,8 @@
 
 #include "tools/function_data.h"
 #include "tools/actions_data.h"
+#include "tools/session_token.h"
+#include "tools/session_store.h"
 
 namespace StructBX
 {
@@ -31,6 +33,7 @@ class StructBX::Functions::Organizations::Users : public Tools::FunctionData
         void ReadSpecific_();
         void ModifyCurrentUsername_();
         void ModifyCurrentPassword_();
+        void RevokeCurrentTokens_();
         void Add_();
         void Modify_();
         void Delete_();
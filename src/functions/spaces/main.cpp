@@ -40,7 +40,7 @@ void Main::Read_()
             return;
         }
 
-        // Iterate over results
+        // Iterate over results, sizes come from the stats cache
         for(auto row : *action->get_results())
         {
             // Get form id
@@ -48,59 +48,10 @@ void Main::Read_()
             if(id->IsNull_())
                 continue;
 
-            // Action 2: Size
-            auto action2 = NAF::Functions::Action("a2");
-            action2.set_sql_code(
-                "SELECT ROUND(SUM((DATA_LENGTH + INDEX_LENGTH)) / 1024 / 1024, 2) AS 'size' " \
-                "FROM information_schema.TABLES " \
-                "WHERE TABLE_SCHEMA = '_structbx_space_" + id->ToString_() + "'"
-            );
-            if(!action2.Work_())
-            {
-                self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error KXkg8nuaNB");
-                return;
-            }
-
-            // Size of space directory
-            auto directory = NAF::Tools::SettingsManager::GetSetting_("directory_for_uploaded_files", "/var/www/structbx-web-uploaded");
-            directory += "/" + id->ToString_();
-            float directory_size = 0;
-            DirectoryIterator it(directory);
-            DirectoryIterator end;
-            while (it != end)
-            {
-                if(it->isDirectory())
-                {
-                    directory_size += it->getSize();
-                    DirectoryIterator it2(it.path());
-                    while (it2 != end)
-                    {
-                        directory_size += it2->getSize();
-                        ++it2;
-                    }
-                }
-                else
-                {
-                    directory_size += it->getSize();
-                }
-
-                ++it;
-            }
-            directory_size = directory_size / 1024.f / 1024.f;
-
-            // Get results
-            auto size = action2.get_results()->First_();
-            if(size->IsNull_())
-            {
-                row->AddField_("size", NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(0)));
-                row->AddField_("directory_size", NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(directory_size)));
-            }
-            else
-            {
-                row->AddField_("size", NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(size->Float_())));
-                row->AddField_("directory_size", NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(directory_size)));
-            }
-
+            auto stats = Tools::SpaceStats::Get_(id->ToString_());
+            row->AddField_("size", NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(stats.size)));
+            row->AddField_("directory_size", NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(stats.directory_size)));
+            row->AddField_("storage_bytes", NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(std::to_string(Tools::StorageAccounting::SpaceBytes_(id->ToString_())))));
         }
 
         // JSON Results
@@ -249,35 +200,43 @@ void Main::Add_()
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action1->get_identifier() + ": " + action1->get_custom_error());
             return;
         }
-        if(!action2->Work_())
-        {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action2->get_identifier() + ": " + action2->get_custom_error());
-            return;
-        }
-        if(!action3->Work_())
+
+        // Action 2 and 3: Add the space and the current user in one transaction
+        Tools::ActionChain chain;
+        chain.Add_(action2).Add_(action3);
+        if(!chain.Work_())
         {
-            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + action3->get_identifier() + ": " + action3->get_custom_error());
+            self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error " + chain.get_failed_identifier() + ": " + chain.get_error());
             return;
         }
 
         // Get space ID
-        auto space_id = action2->get_last_insert_id();
+        auto space_id = chain.get_last_insert_id(action2->get_identifier());
         if(space_id == 0)
         {
             self.JSONResponse_(HTTP::Status::kHTTP_BAD_REQUEST, "Error bq0fyWtqeP");
             return;
         }
 
-        // Create database
+        // Create database on the server chosen for the space (DDL commits implicitly, so it runs after the transaction)
         action4->set_sql_code("CREATE DATABASE _structbx_space_" + std::to_string(space_id));
-        if(!action4->Work_())
+        if(!Tools::RoutedAction::Work_(*action4, Tools::ShardMap::Place_(std::to_string(space_id))))
         {
             self.JSONResponse_(HTTP::Status::kHTTP_INTERNAL_SERVER_ERROR, "Error " + action4->get_identifier() + ": No se pudo crear la DB de espacio");
 
-            // Delete space from table
+            // Delete the placement, space and its users from tables
+            Tools::ShardMap::Forget_(std::to_string(space_id));
             NAF::Functions::Action action5("a5");
-            action5.set_sql_code("DELETE FROM spaces WHERE id = ?");
+            action5.set_sql_code("DELETE FROM spaces_users WHERE id_space = ?");
             action5.AddParameter_("id", std::to_string(space_id), false);
+            NAF::Functions::Action action6("a6");
+            action6.set_sql_code("DELETE FROM spaces WHERE id = ?");
+            action6.AddParameter_("id", std::to_string(space_id), false);
+            NAF::Functions::Action action7("a7");
+            action7.set_sql_code("DELETE FROM spaces_shards WHERE id_space = ?");
+            action7.AddParameter_("id", std::to_string(space_id), false);
+            if(!chain.Compensate_(action5) || !chain.Compensate_(action6) || !chain.Compensate_(action7))
+                NAF::Tools::OutputLogger::Error_("Spaces::Main::Add_: Could not delete space " + std::to_string(space_id));
 
             return;
         }
@@ -7,6 +7,10 @@
 #include "tools/function_data.h"
 #include "tools/base64_tool.h"
 #include "tools/actions_data.h"
+#include "tools/action_chain.h"
+#include "tools/space_stats.h"
+#include "tools/storage_accounting.h"
+#include "tools/shard_map.h"
 
 #include "functions/spaces/users.h"
 
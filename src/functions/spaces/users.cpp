@@ -55,7 +55,7 @@ void Users::ReadUserOutSpace_()
             "su.id_naf_user = nu.id AND "
             "su.id_space = (SELECT s.id FROM spaces s JOIN spaces_users su2 ON su2.id_space = s.id WHERE identifier = ? AND su2.id_naf_user = ? LIMIT 1) "
         "WHERE "
-            "ou.id_organization = (SELECT id_organization FROM organizations_users WHERE id_naf_user = ?) "
+            "ou.id_organization = ? "
             "AND su.id_naf_user IS NULL "
     );
     action1->AddParameter_("identifier_space", "", true)
@@ -69,7 +69,7 @@ void Users::ReadUserOutSpace_()
         return true;
     });
     action1->AddParameter_("id_user", get_id_user(), false);
-    action1->AddParameter_("id_user2", get_id_user(), false);
+    action1->AddParameter_("id_organization", get_organization_id(), false);
 
     get_functions()->push_back(function);
 }
@@ -0,0 +1,51 @@
+
+#include "login_server.h"
+
+StructBX::LoginServer::LoginServer() :
+    LoginHandler()
+{
+
+}
+
+void StructBX::LoginServer::Process_()
+{
+    // A logout ends the signed token and the cached session too, NAF only deletes the session
+    NAF::Tools::Route requested_route(get_http_server_request().value()->getURI());
+    if(requested_route == NAF::Tools::Route("/api/system/logout"))
+    {
+        RevokeToken_();
+        EraseCachedSession_();
+    }
+
+    LoginHandler::Process_();
+}
+
+void StructBX::LoginServer::RevokeToken_()
+{
+    if(!StructBX::Tools::SessionToken::Enabled_())
+        return;
+
+    Poco::Net::NameValueCollection cookies;
+    get_http_server_request().value()->getCookies(cookies);
+    auto token = cookies.find(StructBX::Tools::SessionToken::CookieName_());
+    if(token == cookies.end())
+        return;
+
+    StructBX::Tools::SessionToken::Claims claims;
+    if(StructBX::Tools::SessionToken::Verify_(token->second, claims))
+        StructBX::Tools::SessionToken::RevokeUser_(claims.id_user);
+
+    Net::HTTPCookie cookie(StructBX::Tools::SessionToken::CookieName_(), "");
+    cookie.setPath("/");
+    cookie.setMaxAge(0);
+    get_http_server_response().value()->addCookie(cookie);
+}
+
+void StructBX::LoginServer::EraseCachedSession_()
+{
+    Poco::Net::NameValueCollection cookies;
+    get_http_server_request().value()->getCookies(cookies);
+    auto key = StructBX::Tools::SessionStore::Key_(cookies);
+    if(key != "")
+        StructBX::Tools::SessionStore::Erase_(key);
+}
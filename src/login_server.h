@@ -0,0 +1,33 @@
+
+#ifndef STRUCTBX_LOGINSERVER
+#define STRUCTBX_LOGINSERVER
+
+#include "core/nebula_atom.h"
+#include "handlers/login_handler.h"
+#include "tools/route.h"
+
+#include "tools/session_token.h"
+#include "tools/session_store.h"
+
+namespace StructBX
+{
+    class LoginServer;
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::LoginServer : public Handlers::LoginHandler
+{
+    public:
+        LoginServer();
+        virtual ~LoginServer() {}
+
+        void Process_() override;
+
+    protected:
+        void RevokeToken_();
+        void EraseCachedSession_();
+};
+
+#endif //STRUCTBX_LOGINSERVER
@@ -11,6 +11,20 @@
 
 #include "web_server.h"
 #include "backend_server.h"
+#include "login_server.h"
+#include "tools/form_counters.h"
+#include "tools/file_cleanup_queue.h"
+#include "tools/connection_pool.h"
+#include "tools/async_query.h"
+#include "tools/action_graph.h"
+#include "tools/csv_import.h"
+#include "tools/worker_model.h"
+#include "tools/admission_control.h"
+#include "tools/space_scheduler.h"
+#include "tools/asset_cache.h"
+#include "tools/space_stats.h"
+#include "tools/storage_accounting.h"
+#include "tools/shard_map.h"
 
 using namespace StructBX;
 using namespace NAF;
@@ -19,6 +33,61 @@ void SetupSettings()
 {
     NAF::Tools::SettingsManager::AddSetting_("directory_for_uploaded_files", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("/var/www/structbx-web-uploaded"));
     NAF::Tools::SettingsManager::AddSetting_("space_id_cookie_name", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("1f3efd18688d2"));
+    NAF::Tools::SettingsManager::AddSetting_("change_int_flush_interval", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("1000"));
+    NAF::Tools::SettingsManager::AddSetting_("change_int_flush_batch", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("100"));
+    NAF::Tools::SettingsManager::AddSetting_("total_rows_reconcile_interval", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("3600"));
+    NAF::Tools::SettingsManager::AddSetting_("forms_total_rows", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("counter"));
+    NAF::Tools::SettingsManager::AddSetting_("csv_import_max", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("4"));
+    NAF::Tools::SettingsManager::AddSetting_("bulk_insert_batch", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("500"));
+    NAF::Tools::SettingsManager::AddSetting_("file_cleanup_journal", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("structbx_file_cleanup.journal"));
+    NAF::Tools::SettingsManager::AddSetting_("file_cleanup_interval", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("1000"));
+    NAF::Tools::SettingsManager::AddSetting_("file_cleanup_batch", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("100"));
+    NAF::Tools::SettingsManager::AddSetting_("file_cleanup_attempts", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("5"));
+    NAF::Tools::SettingsManager::AddSetting_("db_pool_min", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("1"));
+    NAF::Tools::SettingsManager::AddSetting_("db_pool_max", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("32"));
+    NAF::Tools::SettingsManager::AddSetting_("db_pool_idle_time", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("60"));
+    NAF::Tools::SettingsManager::AddSetting_("db_pool_wait_ms", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("2000"));
+    NAF::Tools::SettingsManager::AddSetting_("db_pool_ping_after", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("30"));
+    NAF::Tools::SettingsManager::AddSetting_("db_statement_cache_size", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("64"));
+    NAF::Tools::SettingsManager::AddSetting_("server_mode", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("threads"));
+    NAF::Tools::SettingsManager::AddSetting_("server_workers", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("0"));
+    NAF::Tools::SettingsManager::AddSetting_("server_blocking_threads", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("64"));
+    NAF::Tools::SettingsManager::AddSetting_("server_max_queued", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("16384"));
+    NAF::Tools::SettingsManager::AddSetting_("server_thread_stack_kb", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("1024"));
+    NAF::Tools::SettingsManager::AddSetting_("admission_control", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("false"));
+    NAF::Tools::SettingsManager::AddSetting_("admission_queue_ms", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("50"));
+    NAF::Tools::SettingsManager::AddSetting_("admission_initial_limit", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("64"));
+    NAF::Tools::SettingsManager::AddSetting_("admission_min_limit", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("4"));
+    NAF::Tools::SettingsManager::AddSetting_("admission_max_limit", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("1024"));
+    NAF::Tools::SettingsManager::AddSetting_("admission_latency_metadata_ms", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("100"));
+    NAF::Tools::SettingsManager::AddSetting_("admission_latency_data_ms", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("1000"));
+    NAF::Tools::SettingsManager::AddSetting_("admission_latency_write_ms", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("500"));
+    NAF::Tools::SettingsManager::AddSetting_("space_scheduler", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("false"));
+    NAF::Tools::SettingsManager::AddSetting_("space_scheduler_capacity", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("64"));
+    NAF::Tools::SettingsManager::AddSetting_("space_concurrency_limit", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("8"));
+    NAF::Tools::SettingsManager::AddSetting_("space_scheduler_wait_ms", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("5000"));
+    NAF::Tools::SettingsManager::AddSetting_("space_limits", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue(""));
+    NAF::Tools::SettingsManager::AddSetting_("asset_cache_max_mb", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("128"));
+    NAF::Tools::SettingsManager::AddSetting_("asset_cache_max_file_kb", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("2048"));
+    NAF::Tools::SettingsManager::AddSetting_("asset_cache_gzip_min_bytes", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("1024"));
+    NAF::Tools::SettingsManager::AddSetting_("sendfile_min_kb", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("64"));
+    NAF::Tools::SettingsManager::AddSetting_("asset_immutable_max_age", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("31536000"));
+    NAF::Tools::SettingsManager::AddSetting_("asset_immutable_directory", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue(""));
+    NAF::Tools::SettingsManager::AddSetting_("db_async_connections", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("0"));
+    NAF::Tools::SettingsManager::AddSetting_("db_shards", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue(""));
+    NAF::Tools::SettingsManager::AddSetting_("db_replicas", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue(""));
+    NAF::Tools::SettingsManager::AddSetting_("db_replica_sticky_seconds", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("5"));
+    NAF::Tools::SettingsManager::AddSetting_("concurrent_actions_max", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("8"));
+    NAF::Tools::SettingsManager::AddSetting_("action_graph_threads", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("32"));
+    NAF::Tools::SettingsManager::AddSetting_("space_stats_interval", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("300"));
+    NAF::Tools::SettingsManager::AddSetting_("space_quota_mb", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("0"));
+    NAF::Tools::SettingsManager::AddSetting_("membership_cache_ttl", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("300"));
+    NAF::Tools::SettingsManager::AddSetting_("session_tokens", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("false"));
+    NAF::Tools::SettingsManager::AddSetting_("session_token_ttl", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("900"));
+    NAF::Tools::SettingsManager::AddSetting_("session_token_cookie_name", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("5a7c01e94bd32"));
+    NAF::Tools::SettingsManager::AddSetting_("session_token_secret", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue(""));
+    NAF::Tools::SettingsManager::AddSetting_("session_cache_ttl", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("0"));
+    NAF::Tools::SettingsManager::AddSetting_("session_cookie_name", NAF::Tools::DValue::Type::kString, NAF::Tools::DValue("1f3efd18688d2"));
 }
 
 int main(int argc, char** argv)
@@ -29,12 +98,25 @@ int main(int argc, char** argv)
     // Setup settings
         SetupSettings();
         NAF::Tools::SettingsManager::ReadSettings_();
+        StructBX::Tools::WorkerModel::Configure_();
         app.SetupSettings_();
 
     // Setup
         NAF::Query::DatabaseManager::StartMySQL_();
+        StructBX::Tools::StatementCache::Start_();
+        StructBX::Tools::ConnectionPool::Start_();
+        StructBX::Tools::AsyncQuery::Start_();
+        StructBX::Tools::ActionGraph::Start_();
         NAF::Security::PermissionsManager::LoadPermissions_();
         NAF::Tools::SessionsManager::ReadSessions_();
+        StructBX::Tools::ShardMap::Start_();
+        StructBX::Tools::FormCounters::Start_();
+        StructBX::Tools::FileCleanupQueue::Start_();
+        StructBX::Tools::SpaceStats::Start_();
+        StructBX::Tools::StorageAccounting::Start_();
+        StructBX::Tools::AdmissionControl::Start_();
+        StructBX::Tools::SpaceScheduler::Start_();
+        StructBX::Tools::AssetCache::Start_();
 
     // Custom Handler Creator
         app.CustomHandlerCreator_([&](Core::HTTPRequestInfo& info)
@@ -63,7 +145,7 @@ int main(int argc, char** argv)
 
                     if(requested_route == login_route || requested_route == logout_route)
                     {
-                        handler = new NAF::Handlers::LoginHandler();
+                        handler = new StructBX::LoginServer();
                         auto password = handler->get_users_manager().get_action()->GetParameter("password");
                         if(password != handler->get_users_manager().get_action()->get_parameters().end())
                         {
@@ -92,6 +174,14 @@ int main(int argc, char** argv)
         auto code = app.Init_(argc, argv);
 
     // End
+        StructBX::Tools::CSVImport::Stop_();
+        StructBX::Tools::AssetCache::Stop_();
+        StructBX::Tools::SpaceStats::Stop_();
+        StructBX::Tools::FileCleanupQueue::Stop_();
+        StructBX::Tools::FormCounters::Stop_();
+        StructBX::Tools::ActionGraph::Stop_();
+        StructBX::Tools::AsyncQuery::Stop_();
+        StructBX::Tools::ConnectionPool::Stop_();
         NAF::Query::DatabaseManager::StopMySQL_();
         return code;
 }
@@ -0,0 +1,189 @@
+
+#include "tools/action_chain.h"
+
+using namespace StructBX::Tools;
+
+ActionChain::ActionChain(std::string endpoint) :
+    error_("")
+    ,failed_identifier_("")
+    ,endpoint_(endpoint)
+{
+
+}
+
+ActionChain::~ActionChain()
+{
+    try
+    {
+        if(session_ && (*session_)->isTransaction())
+            (*session_)->rollback();
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Error_("ActionChain: " + std::string(e.what()));
+    }
+}
+
+ActionChain& ActionChain::Add_(Functions::Action::Ptr action)
+{
+    actions_.push_back(action);
+    return *this;
+}
+
+bool ActionChain::Work_()
+{
+    // Verify every parameter before touching the database
+    for(auto& action : actions_)
+    {
+        if(!Verify_(*action))
+            return false;
+    }
+
+    try
+    {
+        // Pin one connection for the whole chain
+        if(!session_)
+            session_.reset(new ConnectionPool::Lease(ConnectionPool::Get_(endpoint_)));
+
+        (*session_)->begin();
+        for(auto& action : actions_)
+        {
+            if(!Execute_(*action))
+            {
+                (*session_)->rollback();
+                return false;
+            }
+        }
+        (*session_)->commit();
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Error_("ActionChain: " + std::string(e.what()));
+        error_ = "No se pudo completar la operaci&oacute;n";
+        try
+        {
+            if(session_ && (*session_)->isTransaction())
+                (*session_)->rollback();
+        }
+        catch(std::exception& rollback_error)
+        {
+            NAF::Tools::OutputLogger::Error_("ActionChain: " + std::string(rollback_error.what()));
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool ActionChain::Compensate_(Functions::Action& action)
+{
+    try
+    {
+        if(!session_)
+            session_.reset(new ConnectionPool::Lease(ConnectionPool::Get_(endpoint_)));
+
+        (*session_)->begin();
+        if(!Execute_(action))
+        {
+            (*session_)->rollback();
+            return false;
+        }
+        (*session_)->commit();
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Error_("ActionChain: " + std::string(e.what()));
+        return false;
+    }
+
+    return true;
+}
+
+int ActionChain::get_last_insert_id(std::string identifier)
+{
+    auto found = last_insert_ids_.find(identifier);
+    if(found == last_insert_ids_.end())
+        return 0;
+
+    return found->second;
+}
+
+int ActionChain::get_affected_rows(std::string identifier)
+{
+    auto found = affected_rows_.find(identifier);
+    if(found == affected_rows_.end())
+        return 0;
+
+    return found->second;
+}
+
+bool ActionChain::Verify_(Functions::Action& action)
+{
+    for(auto& param : action.get_parameters())
+    {
+        if(!param->VerifyCondition_())
+        {
+            failed_identifier_ = action.get_identifier();
+            error_ = param->get_error();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ActionChain::Execute_(Functions::Action& action)
+{
+    // Bind values, empty values are NULL
+    std::vector<Poco::Nullable<std::string>> values;
+    values.reserve(action.get_parameters().size());
+    for(auto& param : action.get_parameters())
+    {
+        if(param->get_value()->TypeIsIqual_(NAF::Tools::DValue::Type::kEmpty))
+            values.push_back(Poco::Nullable<std::string>());
+        else
+            values.push_back(Poco::Nullable<std::string>(param->get_value()->ToString_()));
+    }
+
+    try
+    {
+        // Inside the transaction a failed statement is not executed again
+        auto& statements = session_->Statements_();
+        auto& statement = statements.Execute_(**session_, action.get_sql_code(), values, false).statement;
+        affected_rows_[action.get_identifier()] = static_cast<int>(statement.affectedRowCount());
+        if(statement.columnsExtracted() > 0)
+            RoutedAction::Results_(action, statement);
+
+        // Last insert id from the client library, without a round trip
+        if(Insert_(action.get_sql_code()))
+            last_insert_ids_[action.get_identifier()] = (*session_)->getProperty("insertId").convert<int>();
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Error_("ActionChain (" + action.get_identifier() + "): " + std::string(e.what()));
+        failed_identifier_ = action.get_identifier();
+        error_ = "No se pudo completar la operaci&oacute;n";
+        return false;
+    }
+
+    // Action conditions verify the results, as Action::Work_ does
+    auto condition = action.get_condition();
+    if(condition && condition->get_type() == Query::ConditionType::kError && !condition->get_functor()(action))
+    {
+        failed_identifier_ = action.get_identifier();
+        error_ = action.get_custom_error();
+        return false;
+    }
+
+    return true;
+}
+
+bool ActionChain::Insert_(const std::string& sql)
+{
+    auto first = sql.find_first_not_of(" \t\r\n(");
+    if(first == std::string::npos)
+        return false;
+
+    auto keyword = Poco::toUpper(sql.substr(first, 7));
+    return keyword.compare(0, 6, "INSERT") == 0 || keyword == "REPLACE";
+}
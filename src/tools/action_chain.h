@@ -0,0 +1,71 @@
+
+#ifndef STRUCTBX_TOOLS_ACTIONCHAIN
+#define STRUCTBX_TOOLS_ACTIONCHAIN
+
+#include <map>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "Poco/Nullable.h"
+#include "Poco/String.h"
+#include "Poco/Data/Session.h"
+#include "Poco/Data/Statement.h"
+#include "Poco/Data/RecordSet.h"
+
+#include "functions/action.h"
+#include <query/parameter.h>
+#include <tools/output_logger.h>
+
+#include "tools/connection_pool.h"
+#include "tools/routed_action.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class ActionChain;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::ActionChain
+{
+    public:
+        // Runs on the primary, or on the given ConnectionPool endpoint
+        ActionChain(std::string endpoint = "");
+        ~ActionChain();
+
+        ActionChain& Add_(Functions::Action::Ptr action);
+
+        // Verifies every parameter first, then runs the actions on one connection
+        // inside a transaction, rolling back if any of them fails. Rows of SELECTs
+        // are left in the action results
+        bool Work_();
+
+        // Runs actions on the same connection after Work_, committed one by one
+        bool Compensate_(Functions::Action& action);
+
+        int get_last_insert_id(std::string identifier);
+        int get_affected_rows(std::string identifier);
+        std::string get_error() const { return error_; }
+        std::string get_failed_identifier() const { return failed_identifier_; }
+
+    protected:
+        bool Verify_(Functions::Action& action);
+        bool Execute_(Functions::Action& action);
+        static bool Insert_(const std::string& sql);
+
+    private:
+        std::list<Functions::Action::Ptr> actions_;
+        std::map<std::string, int> last_insert_ids_;
+        std::map<std::string, int> affected_rows_;
+        std::string error_;
+        std::string failed_identifier_;
+        std::string endpoint_;
+        std::unique_ptr<ConnectionPool::Lease> session_;
+};
+
+#endif //STRUCTBX_TOOLS_ACTIONCHAIN
@@ -0,0 +1,228 @@
+
+#include "tools/action_graph.h"
+
+using namespace StructBX::Tools;
+
+std::unique_ptr<Poco::ThreadPool> ActionGraph::pool_;
+std::mutex ActionGraph::pool_mutex_;
+
+ActionGraph::ActionGraph() :
+    failed_identifier_("")
+    ,max_concurrency_(8)
+    ,finished_(0)
+    ,helpers_(0)
+    ,pending_(nullptr)
+    ,dependents_(nullptr)
+    ,helper_(*this, &ActionGraph::Help_)
+{
+    try
+    {
+        max_concurrency_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("concurrent_actions_max", "8"));
+    }
+    catch(std::exception&){NAF::Tools::OutputLogger::Error_("concurrent_actions_max setting is not an integer");}
+    if(max_concurrency_ < 1)
+        max_concurrency_ = 1;
+}
+
+void ActionGraph::Start_()
+{
+    int threads = 32;
+    try
+    {
+        threads = std::stoi(NAF::Tools::SettingsManager::GetSetting_("action_graph_threads", "32"));
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("ActionGraph: action_graph_threads must be an integer");
+    }
+
+    // Without workers every graph runs on its caller
+    std::unique_lock<std::mutex> lock(pool_mutex_);
+    if(pool_ || threads < 1)
+        return;
+    pool_.reset(new Poco::ThreadPool("ActionGraph", 1, threads));
+}
+
+void ActionGraph::Stop_()
+{
+    std::unique_lock<std::mutex> lock(pool_mutex_);
+    if(!pool_)
+        return;
+    pool_->joinAll();
+    pool_.reset();
+}
+
+ActionGraph& ActionGraph::Add_(std::string identifier, Work work, std::vector<std::string> dependencies)
+{
+    nodes_.push_back(Node{identifier, work, nullptr, dependencies});
+    return *this;
+}
+
+ActionGraph& ActionGraph::Add_(Functions::Action::Ptr action, std::vector<std::string> dependencies)
+{
+    return Add_(action->get_identifier(), [action]{ return RoutedAction::Prepared_(*action); }, dependencies);
+}
+
+ActionGraph& ActionGraph::AddAsync_(Functions::Action::Ptr action, std::vector<std::string> dependencies)
+{
+    if(!AsyncQuery::Enabled_())
+        return Add_(action, dependencies);
+
+    nodes_.push_back(Node{action->get_identifier(), nullptr, [action]{ return AsyncQuery::Work_(action); }, dependencies});
+    return *this;
+}
+
+bool ActionGraph::Work_()
+{
+    // Dependencies left and dependents of every node, a dependency must be added before its dependents
+    failed_identifier_ = "";
+    std::map<std::string, std::size_t> indexes;
+    for(std::size_t i = 0; i < nodes_.size(); i++)
+        indexes[nodes_[i].identifier] = i;
+
+    std::vector<std::size_t> pending(nodes_.size(), 0);
+    std::vector<std::vector<std::size_t>> dependents(nodes_.size());
+    for(std::size_t i = 0; i < nodes_.size(); i++)
+    {
+        for(auto& dependency : nodes_[i].dependencies)
+        {
+            auto found = indexes.find(dependency);
+            if(found == indexes.end() || found->second >= i)
+            {
+                NAF::Tools::OutputLogger::Error_("ActionGraph: Unknown dependency " + dependency + " of " + nodes_[i].identifier);
+                continue;
+            }
+            pending[i]++;
+            dependents[found->second].push_back(i);
+        }
+    }
+
+    states_.assign(nodes_.size(), State::kWaiting);
+    ready_.clear();
+    finished_ = 0;
+    for(std::size_t i = 0; i < nodes_.size(); i++)
+    {
+        if(pending[i] == 0)
+            Ready_(i, dependents);
+    }
+
+    // At most concurrent_actions_max nodes run at once, the caller is one of the workers
+    // and the rest are borrowed from the pool while it has free threads
+    pending_ = &pending;
+    dependents_ = &dependents;
+    auto worker_count = std::min(max_concurrency_, std::max<std::size_t>(nodes_.size() - finished_, 1));
+    {
+        std::unique_lock<std::mutex> pool_lock(pool_mutex_);
+        for(std::size_t i = 1; pool_ && i < worker_count; i++)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                helpers_++;
+            }
+            try
+            {
+                pool_->start(helper_);
+            }
+            catch(Poco::NoThreadAvailableException&)
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                helpers_--;
+                break;
+            }
+        }
+    }
+    Run_(pending, dependents);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]{ return helpers_ == 0; });
+    }
+
+    // Async nodes nobody depends on finish on the event loop
+    for(auto& it : submitted_)
+        states_[it.first] = it.second.get() ? State::kSucceeded : State::kFailed;
+    submitted_.clear();
+
+    // The first failed node in the order they were added
+    for(std::size_t i = 0; i < nodes_.size(); i++)
+    {
+        if(states_[i] != State::kSucceeded)
+        {
+            failed_identifier_ = nodes_[i].identifier;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ActionGraph::Ready_(std::size_t index, std::vector<std::vector<std::size_t>>& dependents)
+{
+    // Submitted right away and left to the event loop, it takes no worker
+    auto& node = nodes_[index];
+    if(node.async_work && dependents[index].empty())
+    {
+        states_[index] = State::kRunning;
+        submitted_.emplace_back(index, node.async_work());
+        finished_++;
+        return;
+    }
+
+    ready_.push_back(index);
+}
+
+void ActionGraph::Run_(std::vector<std::size_t>& pending, std::vector<std::vector<std::size_t>>& dependents)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(true)
+    {
+        condition_.wait(lock, [this]{ return !ready_.empty() || finished_ == nodes_.size(); });
+        if(ready_.empty())
+            break;
+
+        auto index = ready_.front();
+        ready_.pop_front();
+        states_[index] = State::kRunning;
+        auto& node = nodes_[index];
+
+        lock.unlock();
+        bool result = false;
+        try
+        {
+            result = node.work ? node.work() : node.async_work().get();
+        }
+        catch(std::exception& e)
+        {
+            NAF::Tools::OutputLogger::Error_("ActionGraph: " + std::string(e.what()));
+        }
+        lock.lock();
+
+        Finish_(index, result, pending, dependents);
+        condition_.notify_all();
+    }
+}
+
+void ActionGraph::Help_()
+{
+    Run_(*pending_, *dependents_);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    helpers_--;
+    condition_.notify_all();
+}
+
+void ActionGraph::Finish_(std::size_t index, bool result, std::vector<std::size_t>& pending, std::vector<std::vector<std::size_t>>& dependents)
+{
+    states_[index] = result ? State::kSucceeded : State::kFailed;
+    finished_++;
+
+    // Dependents of a failed node never run
+    for(auto dependent : dependents[index])
+    {
+        if(states_[dependent] != State::kWaiting)
+            continue;
+        if(!result)
+            Finish_(dependent, false, pending, dependents);
+        else if(--pending[dependent] == 0)
+            Ready_(dependent, dependents);
+    }
+}
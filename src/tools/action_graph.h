@@ -0,0 +1,107 @@
+
+#ifndef STRUCTBX_TOOLS_ACTIONGRAPH
+#define STRUCTBX_TOOLS_ACTIONGRAPH
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <future>
+#include <string>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include "Poco/Exception.h"
+#include "Poco/ThreadPool.h"
+#include "Poco/RunnableAdapter.h"
+
+#include "core/nebula_atom.h"
+#include "functions/action.h"
+#include <tools/output_logger.h>
+
+#include "tools/async_query.h"
+#include "tools/routed_action.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class ActionGraph;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::ActionGraph
+{
+    public:
+        using Work = std::function<bool()>;
+        using AsyncWork = std::function<std::future<bool>()>;
+
+        ActionGraph();
+
+        // Workers shared by every graph, action_graph_threads at most
+        static void Start_();
+        static void Stop_();
+
+        // A node starts when every node in dependencies finished successfully
+        ActionGraph& Add_(std::string identifier, Work work, std::vector<std::string> dependencies = {});
+        ActionGraph& Add_(Functions::Action::Ptr action, std::vector<std::string> dependencies = {});
+
+        // Runs the action on AsyncQuery, a node without dependencies takes no thread while
+        // it waits. Only for actions without action conditions, falls back to Add_
+        ActionGraph& AddAsync_(Functions::Action::Ptr action, std::vector<std::string> dependencies = {});
+
+        // Runs independent nodes concurrently on at most concurrent_actions_max threads, the
+        // caller and pooled workers while there are free ones. Returns false if any node failed
+        bool Work_();
+
+        // First failed node in the order they were added
+        std::string get_failed_identifier() const { return failed_identifier_; }
+
+    protected:
+        struct Node
+        {
+            std::string identifier;
+            Work work;
+            AsyncWork async_work;
+            std::vector<std::string> dependencies;
+        };
+
+        enum class State
+        {
+            kWaiting
+            ,kRunning
+            ,kSucceeded
+            ,kFailed
+        };
+
+        void Ready_(std::size_t index, std::vector<std::vector<std::size_t>>& dependents);
+        void Run_(std::vector<std::size_t>& pending, std::vector<std::vector<std::size_t>>& dependents);
+        void Help_();
+        void Finish_(std::size_t index, bool result, std::vector<std::size_t>& pending, std::vector<std::vector<std::size_t>>& dependents);
+
+    private:
+        std::vector<Node> nodes_;
+        std::string failed_identifier_;
+        std::size_t max_concurrency_;
+        std::vector<State> states_;
+        std::deque<std::size_t> ready_;
+        std::vector<std::pair<std::size_t, std::future<bool>>> submitted_;
+        std::size_t finished_;
+        std::size_t helpers_;
+        std::vector<std::size_t>* pending_;
+        std::vector<std::vector<std::size_t>>* dependents_;
+        Poco::RunnableAdapter<ActionGraph> helper_;
+        std::mutex mutex_;
+        std::condition_variable condition_;
+
+        static std::unique_ptr<Poco::ThreadPool> pool_;
+        static std::mutex pool_mutex_;
+};
+
+#endif //STRUCTBX_TOOLS_ACTIONGRAPH
@@ -461,13 +461,8 @@ void ActionsData::Spaces::ReadSpecificA01::Setup_(Functions::Action::Ptr action)
 {
     action_ = action;
 
-    action_->set_sql_code(
-        "SELECT s.* " \
-        "FROM spaces s " \
-        "JOIN spaces_users su ON su.id_space = s.id " \
-        "WHERE su.id_naf_user = ? AND s.id = ?"
-    );
-    action_->AddParameter_("id_naf_user", get_id_user(), false);
+    // The space id was already checked against MembershipCache
+    action_->set_sql_code("SELECT s.* FROM spaces s WHERE s.id = ?");
     action_->AddParameter_("id_space", get_space_id(), false);
 }
 
@@ -785,9 +780,11 @@ void ActionsData::Forms::ReadA01::Setup_(Functions::Action::Ptr action)
 {
     action_ = action;
 
+    // Row totals come from the counters kept by FormCounters, the InnoDB estimates
+    // are read by the function where the space database is
     action->set_sql_code(
         "SELECT " \
-            "f.* " \
+            "f.*, f.total_rows AS stored_total " \
         "FROM forms f " \
         "WHERE " \
             "id_space = ? "
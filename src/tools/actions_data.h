@@ -4,6 +4,7 @@
 
 #include "tools/base_action.h"
 #include "tools/function_data.h"
+#include "tools/form_counters.h"
 
 namespace StructBX
 {
@@ -0,0 +1,162 @@
+
+#include "tools/admission_control.h"
+
+using namespace StructBX::Tools;
+
+bool AdmissionControl::enabled_ = false;
+double AdmissionControl::min_limit_ = 4;
+double AdmissionControl::max_limit_ = 1024;
+std::chrono::milliseconds AdmissionControl::queue_target_(50);
+std::array<AdmissionControl::Limiter, 3> AdmissionControl::limiters_;
+
+AdmissionControl::Ticket::Ticket(Class type) :
+    type_(type)
+    ,admitted_(true)
+{
+    if(enabled_)
+        admitted_ = Acquire_(type_);
+
+    // Queue wait is not part of the latency
+    start_ = std::chrono::steady_clock::now();
+}
+
+void AdmissionControl::Ticket::Restart_()
+{
+    start_ = std::chrono::steady_clock::now();
+}
+
+void AdmissionControl::Ticket::Suspend_()
+{
+    if(enabled_ && admitted_)
+        Cancel_(type_);
+    admitted_ = false;
+}
+
+bool AdmissionControl::Ticket::Resume_()
+{
+    admitted_ = !enabled_ || Acquire_(type_, true);
+    start_ = std::chrono::steady_clock::now();
+    return admitted_;
+}
+
+AdmissionControl::Ticket::~Ticket()
+{
+    if(enabled_ && admitted_)
+        Release_(type_, std::chrono::steady_clock::now() - start_);
+}
+
+int AdmissionControl::Ticket::RetryAfter_() const
+{
+    // About the time a request of this class takes
+    auto& limiter = Limiter_(type_);
+    return std::max<int>(1, std::chrono::duration_cast<std::chrono::seconds>(limiter.latency_target + std::chrono::milliseconds(999)).count());
+}
+
+void AdmissionControl::Start_()
+{
+    // Settings
+    enabled_ = NAF::Tools::SettingsManager::GetSetting_("admission_control", "false") == "true";
+    std::array<std::string, 3> names = {"metadata", "data", "write"};
+    std::array<std::string, 3> targets = {"100", "1000", "500"};
+    try
+    {
+        min_limit_ = std::max(1, std::stoi(NAF::Tools::SettingsManager::GetSetting_("admission_min_limit", "4")));
+        max_limit_ = std::max<double>(min_limit_, std::stoi(NAF::Tools::SettingsManager::GetSetting_("admission_max_limit", "1024")));
+        queue_target_ = std::chrono::milliseconds(std::stoi(NAF::Tools::SettingsManager::GetSetting_("admission_queue_ms", "50")));
+        auto initial = std::stod(NAF::Tools::SettingsManager::GetSetting_("admission_initial_limit", "64"));
+        for(std::size_t i = 0; i < limiters_.size(); ++i)
+        {
+            limiters_[i].name = names[i];
+            limiters_[i].limit = std::min(max_limit_, std::max(min_limit_, initial));
+            limiters_[i].latency_target = std::chrono::milliseconds(
+                std::stoi(NAF::Tools::SettingsManager::GetSetting_("admission_latency_" + names[i] + "_ms", targets[i]))
+            );
+        }
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("AdmissionControl: admission_* settings must be integers");
+    }
+}
+
+AdmissionControl::Class AdmissionControl::Classify_(std::string method, std::string path)
+{
+    if(method != "GET")
+        return Class::kWrite;
+    if(path.compare(0, 16, "/api/forms/data/") == 0)
+        return Class::kData;
+
+    return Class::kMetadata;
+}
+
+Poco::JSON::Object::Ptr AdmissionControl::Metrics_()
+{
+    Poco::JSON::Object::Ptr metrics = new Poco::JSON::Object;
+    metrics->set("enabled", enabled_);
+    for(auto& limiter : limiters_)
+    {
+        std::unique_lock<std::mutex> lock(limiter.mutex);
+        Poco::JSON::Object::Ptr object = new Poco::JSON::Object;
+        object->set("limit", static_cast<int>(limiter.limit));
+        object->set("in_flight", limiter.in_flight);
+        object->set("admitted", limiter.admitted);
+        object->set("rejected", limiter.rejected);
+        metrics->set(limiter.name, object);
+    }
+
+    return metrics;
+}
+
+bool AdmissionControl::Acquire_(Class type, bool resumed)
+{
+    // Wait for a slot at most the queueing delay target, then fail fast
+    auto& limiter = Limiter_(type);
+    std::unique_lock<std::mutex> lock(limiter.mutex);
+    auto admitted = limiter.available.wait_for(lock, queue_target_, [&limiter]{
+        return limiter.in_flight < static_cast<std::size_t>(limiter.limit);
+    });
+    if(!admitted)
+    {
+        limiter.rejected++;
+        return false;
+    }
+
+    limiter.in_flight++;
+    if(!resumed)
+        limiter.admitted++;
+    return true;
+}
+
+void AdmissionControl::Release_(Class type, std::chrono::steady_clock::duration latency)
+{
+    auto& limiter = Limiter_(type);
+    {
+        std::unique_lock<std::mutex> lock(limiter.mutex);
+        limiter.in_flight--;
+
+        // AIMD: slow requests shrink the limit once per target window, fast ones grow it
+        auto now = std::chrono::steady_clock::now();
+        if(latency > limiter.latency_target)
+        {
+            if(now - limiter.last_decrease > limiter.latency_target)
+            {
+                limiter.limit = std::max(min_limit_, limiter.limit * 0.9);
+                limiter.last_decrease = now;
+            }
+        }
+        else
+            limiter.limit = std::min(max_limit_, limiter.limit + 1.0 / limiter.limit);
+    }
+    limiter.available.notify_one();
+}
+
+void AdmissionControl::Cancel_(Class type)
+{
+    // No latency sample, the time went to waiting
+    auto& limiter = Limiter_(type);
+    {
+        std::unique_lock<std::mutex> lock(limiter.mutex);
+        limiter.in_flight--;
+    }
+    limiter.available.notify_one();
+}
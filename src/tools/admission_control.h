@@ -0,0 +1,99 @@
+
+#ifndef STRUCTBX_TOOLS_ADMISSIONCONTROL
+#define STRUCTBX_TOOLS_ADMISSIONCONTROL
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
+
+#include "Poco/JSON/Object.h"
+
+#include "core/nebula_atom.h"
+#include <tools/output_logger.h>
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class AdmissionControl;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::AdmissionControl
+{
+    public:
+        enum class Class
+        {
+            kMetadata
+            ,kData
+            ,kWrite
+        };
+
+        // Holds a slot of its class while the request runs
+        class Ticket
+        {
+            public:
+                Ticket(Class type);
+                ~Ticket();
+
+                bool Admitted_() const { return admitted_; }
+
+                // Latency is measured from here, once the request body has been read
+                void Restart_();
+
+                // Gives the slot back while the request waits elsewhere, Resume_ takes
+                // one again and measures from there. False if none is free in time
+                void Suspend_();
+                bool Resume_();
+
+                // Seconds for the Retry-After header of a rejected request
+                int RetryAfter_() const;
+
+            private:
+                Class type_;
+                bool admitted_;
+                std::chrono::steady_clock::time_point start_;
+        };
+
+        static void Start_();
+        static bool Enabled_() { return enabled_; }
+
+        // Non GET requests are writes, GETs under /api/forms/data/ are data reads and exports
+        static Class Classify_(std::string method, std::string path);
+
+        // Limits, in flight, admitted and rejected per class
+        static Poco::JSON::Object::Ptr Metrics_();
+
+    private:
+        struct Limiter
+        {
+            std::string name;
+            std::mutex mutex;
+            std::condition_variable available;
+            double limit = 64;
+            std::size_t in_flight = 0;
+            std::chrono::milliseconds latency_target{500};
+            std::chrono::steady_clock::time_point last_decrease;
+            unsigned long long admitted = 0;
+            unsigned long long rejected = 0;
+        };
+
+        static bool Acquire_(Class type, bool resumed = false);
+        static void Release_(Class type, std::chrono::steady_clock::duration latency);
+        static void Cancel_(Class type);
+        static Limiter& Limiter_(Class type) { return limiters_[static_cast<std::size_t>(type)]; }
+
+        static bool enabled_;
+        static double min_limit_;
+        static double max_limit_;
+        static std::chrono::milliseconds queue_target_;
+        static std::array<Limiter, 3> limiters_;
+};
+
+#endif //STRUCTBX_TOOLS_ADMISSIONCONTROL
@@ -0,0 +1,376 @@
+
+#include "tools/asset_cache.h"
+
+using namespace StructBX::Tools;
+
+std::mutex AssetCache::mutex_;
+std::map<std::string, AssetCache::Ptr> AssetCache::assets_;
+std::map<std::string, AssetCache::Validator> AssetCache::validators_;
+std::map<int, std::string> AssetCache::watches_;
+std::thread AssetCache::watcher_;
+bool AssetCache::enabled_ = false;
+bool AssetCache::running_ = false;
+int AssetCache::inotify_fd_ = -1;
+std::string AssetCache::directory_ = "/var/www";
+std::string AssetCache::immutable_directory_ = "";
+unsigned long long AssetCache::generation_ = 0;
+std::size_t AssetCache::bytes_ = 0;
+std::size_t AssetCache::max_bytes_ = 128 * 1024 * 1024;
+std::size_t AssetCache::max_file_bytes_ = 2 * 1024 * 1024;
+std::size_t AssetCache::gzip_min_bytes_ = 1024;
+std::size_t AssetCache::max_validators_ = 4096;
+
+void AssetCache::Start_()
+{
+    // Settings
+    directory_ = Directory_(NAF::Tools::SettingsManager::GetSetting_("directory_base", "/var/www"));
+    auto immutable_directory = NAF::Tools::SettingsManager::GetSetting_("asset_immutable_directory", "");
+    while(immutable_directory != "" && immutable_directory.front() == '/')
+        immutable_directory.erase(0, 1);
+    if(immutable_directory != "")
+        immutable_directory_ = Directory_(directory_ + "/" + immutable_directory);
+    try
+    {
+        max_bytes_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("asset_cache_max_mb", "128")) * 1024 * 1024;
+        max_file_bytes_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("asset_cache_max_file_kb", "2048")) * 1024;
+        gzip_min_bytes_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("asset_cache_gzip_min_bytes", "1024"));
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("AssetCache: asset_cache_max_mb, asset_cache_max_file_kb and asset_cache_gzip_min_bytes must be integers");
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(running_ || max_bytes_ == 0)
+        return;
+
+    // Without inotify changed files would be served stale, so nothing is cached
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotify_fd_ < 0)
+    {
+        NAF::Tools::OutputLogger::Error_("AssetCache: inotify is not available, the asset cache is disabled");
+        return;
+    }
+    running_ = true;
+    enabled_ = true;
+
+    lock.unlock();
+    Watch_(directory_);
+    lock.lock();
+    watcher_ = std::thread(&AssetCache::WatchWork_);
+}
+
+void AssetCache::Stop_()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(!running_)
+            return;
+        running_ = false;
+        enabled_ = false;
+    }
+    if(watcher_.joinable())
+        watcher_.join();
+    close(inotify_fd_);
+    inotify_fd_ = -1;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    assets_.clear();
+    validators_.clear();
+    bytes_ = 0;
+}
+
+AssetCache::Ptr AssetCache::Find_(std::string uri)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(!enabled_)
+        return nullptr;
+
+    auto found = assets_.find(Path_(uri));
+    if(found == assets_.end())
+        return nullptr;
+
+    return found->second;
+}
+
+AssetCache::Ptr AssetCache::Load_(std::string uri, std::string content_type)
+{
+    // A change while reading makes the read stale
+    unsigned long long generation;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(!enabled_)
+            return nullptr;
+        generation = generation_;
+    }
+
+    auto path = Path_(uri);
+    if(path == "")
+        return nullptr;
+
+    auto asset = std::make_shared<Asset>();
+    try
+    {
+        Poco::File file(path);
+        if(!file.isFile() || file.getSize() > max_file_bytes_)
+            return nullptr;
+        asset->path = path;
+        asset->content_type = content_type;
+        asset->validator.modified = file.getLastModified();
+
+        std::ifstream stream(path, std::ios::binary);
+        std::stringstream body;
+        body << stream.rdbuf();
+        asset->body = body.str();
+        asset->validator.size = asset->body.size();
+
+        Poco::SHA1Engine sha1;
+        sha1.update(asset->body.data(), asset->body.size());
+        asset->validator.etag = "\"" + Poco::DigestEngine::digestToHex(sha1.digest()) + "\"";
+
+        // Precompressed once, only kept if it saves something
+        if(asset->body.size() >= gzip_min_bytes_)
+        {
+            std::stringstream gzip;
+            Poco::DeflatingOutputStream deflater(gzip, Poco::DeflatingStreamBuf::STREAM_GZIP, 9);
+            deflater.write(asset->body.data(), asset->body.size());
+            deflater.close();
+            if(gzip.str().size() < asset->body.size())
+                asset->gzip = gzip.str();
+        }
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Debug_("AssetCache: " + std::string(e.what()));
+        return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto size = asset->body.size() + asset->gzip.size();
+    auto found = assets_.find(path);
+    if(found != assets_.end())
+        return found->second;
+    if(generation != generation_ || bytes_ + size > max_bytes_)
+        return nullptr;
+
+    assets_[path] = asset;
+    bytes_ += size;
+    return asset;
+}
+
+std::string AssetCache::Path_(std::string uri)
+{
+    // The same file FileManager would serve, nothing outside directory_base
+    std::string path;
+    try
+    {
+        path = Poco::URI(uri).getPath();
+    }
+    catch(std::exception&)
+    {
+        return "";
+    }
+    if(path.find("..") != std::string::npos)
+        return "";
+    if(path == "" || path.back() == '/')
+        path += "index.html";
+
+    return directory_ + path;
+}
+
+bool AssetCache::Validator_(std::string path, Validator& validator)
+{
+    try
+    {
+        Poco::File file(path);
+        if(!file.isFile())
+            return false;
+        auto modified = file.getLastModified();
+        auto size = file.getSize();
+
+        // Files over the cache limit are not read for a tag, they go out with sendfile
+        if(size > max_file_bytes_)
+        {
+            validator.etag = "W/\"" + std::to_string(size) + "-" + std::to_string(modified.epochMicroseconds()) + "\"";
+            validator.modified = modified;
+            validator.size = size;
+            return true;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto found = validators_.find(path);
+            if(found != validators_.end() && found->second.modified == modified && found->second.size == size)
+            {
+                validator = found->second;
+                return true;
+            }
+        }
+
+        // Hash the content once, a change of size or time hashes it again
+        Poco::SHA1Engine sha1;
+        Poco::DigestOutputStream digest(sha1);
+        std::ifstream stream(path, std::ios::binary);
+        Poco::StreamCopier::copyStream(stream, digest);
+        digest.close();
+
+        validator.etag = "\"" + Poco::DigestEngine::digestToHex(sha1.digest()) + "\"";
+        validator.modified = modified;
+        validator.size = size;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(validators_.size() >= max_validators_ && validators_.find(path) == validators_.end())
+            validators_.erase(validators_.begin());
+        validators_[path] = validator;
+        return true;
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Debug_("AssetCache: " + std::string(e.what()));
+        return false;
+    }
+}
+
+bool AssetCache::Immutable_(std::string path)
+{
+    // Only under the build directory if one is set
+    if(immutable_directory_ != "" && path.compare(0, immutable_directory_.size() + 1, immutable_directory_ + "/") != 0)
+        return false;
+
+    // name-<hash>.ext or name.<hash>.ext, a hex hash of a bundler length with letters and digits,
+    // so dates and version names are not taken for one
+    auto slash = path.rfind('/');
+    auto name = slash == std::string::npos ? path : path.substr(slash + 1);
+    auto extension = name.rfind('.');
+    if(extension == std::string::npos || extension == 0)
+        return false;
+    auto separator = name.find_last_of(".-", extension - 1);
+    if(separator == std::string::npos)
+        return false;
+
+    auto hash = name.substr(separator + 1, extension - separator - 1);
+    switch(hash.size())
+    {
+        case 8: case 10: case 12: case 16: case 20: case 32: case 40: case 64:
+            break;
+        default:
+            return false;
+    }
+    bool digit = false;
+    bool letter = false;
+    for(auto character : hash)
+    {
+        if(!std::isxdigit(static_cast<unsigned char>(character)))
+            return false;
+        digit = digit || std::isdigit(static_cast<unsigned char>(character));
+        letter = letter || std::isalpha(static_cast<unsigned char>(character));
+    }
+
+    return digit && letter;
+}
+
+std::string AssetCache::Directory_(std::string directory)
+{
+    while(directory.size() > 1 && directory.back() == '/')
+        directory.pop_back();
+
+    return directory;
+}
+
+void AssetCache::Invalidate_(std::string path)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    generation_++;
+    auto it = assets_.lower_bound(path);
+    while(it != assets_.end() && it->first.compare(0, path.size(), path) == 0)
+    {
+        bytes_ -= it->second->body.size() + it->second->gzip.size();
+        it = assets_.erase(it);
+    }
+    auto validator = validators_.lower_bound(path);
+    while(validator != validators_.end() && validator->first.compare(0, path.size(), path) == 0)
+        validator = validators_.erase(validator);
+}
+
+void AssetCache::Watch_(std::string path)
+{
+    int wd = inotify_add_watch(inotify_fd_, path.c_str(), IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB);
+    if(wd < 0)
+    {
+        NAF::Tools::OutputLogger::Debug_("AssetCache: Could not watch " + path);
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        watches_[wd] = path;
+    }
+
+    // inotify is not recursive, watch every subdirectory
+    try
+    {
+        Poco::DirectoryIterator it(path);
+        Poco::DirectoryIterator end;
+        for(; it != end; ++it)
+        {
+            if(it->isDirectory() && !it->isLink())
+                Watch_(it->path());
+        }
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Debug_("AssetCache: " + std::string(e.what()));
+    }
+}
+
+void AssetCache::WatchWork_()
+{
+    alignas(struct inotify_event) char buffer[4096];
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if(!running_)
+                break;
+        }
+
+        struct pollfd pfd = {inotify_fd_, POLLIN, 0};
+        if(poll(&pfd, 1, 500) <= 0)
+            continue;
+
+        auto length = read(inotify_fd_, buffer, sizeof(buffer));
+        if(length <= 0)
+            continue;
+
+        for(char* ptr = buffer; ptr < buffer + length;)
+        {
+            auto event = reinterpret_cast<struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if(event->mask & IN_Q_OVERFLOW)
+            {
+                Invalidate_("");
+                continue;
+            }
+
+            std::string directory;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                auto found = watches_.find(event->wd);
+                if(found == watches_.end())
+                    continue;
+                if(event->mask & IN_IGNORED)
+                {
+                    watches_.erase(found);
+                    continue;
+                }
+                directory = found->second;
+            }
+
+            // A directory event drops everything below it
+            auto path = event->len > 0 ? directory + "/" + std::string(event->name) : directory;
+            if((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+                Watch_(path);
+            Invalidate_(path);
+        }
+    }
+}
@@ -0,0 +1,107 @@
+
+#ifndef STRUCTBX_TOOLS_ASSETCACHE
+#define STRUCTBX_TOOLS_ASSETCACHE
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cctype>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "Poco/URI.h"
+#include "Poco/File.h"
+#include "Poco/Timestamp.h"
+#include "Poco/DirectoryIterator.h"
+#include "Poco/DeflatingStream.h"
+#include "Poco/SHA1Engine.h"
+#include "Poco/DigestStream.h"
+#include "Poco/StreamCopier.h"
+
+#include "core/nebula_atom.h"
+#include <tools/output_logger.h>
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class AssetCache;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+// Frontend files kept in memory with a gzip variant, inotify drops the changed ones
+class StructBX::Tools::AssetCache
+{
+    public:
+        struct Validator
+        {
+            std::string etag;
+            Poco::Timestamp modified;
+            Poco::File::FileSize size = 0;
+        };
+
+        struct Asset
+        {
+            std::string path;
+            std::string content_type;
+            std::string body;
+            std::string gzip;
+            Validator validator;
+        };
+
+        using Ptr = std::shared_ptr<const Asset>;
+
+        static void Start_();
+        static void Stop_();
+
+        // Null if the file of the URI under directory_base is not cached
+        static Ptr Find_(std::string uri);
+
+        // Reads the file of the URI, null if it is too big or does not fit the budget
+        static Ptr Load_(std::string uri, std::string content_type);
+
+        // File under directory_base that the URI maps to, "" if it points outside
+        static std::string Path_(std::string uri);
+
+        // Strong validator of a file up to asset_cache_max_file_kb, hashed once and kept while its
+        // size and modification time stay. Larger files get a weak size-mtime tag without reading them
+        static bool Validator_(std::string path, Validator& validator);
+
+        // Bundles with a hex content hash in their name, like index-4f2a9c1b.js, never change.
+        // With asset_immutable_directory set only files under it qualify
+        static bool Immutable_(std::string path);
+
+    private:
+        static std::string Directory_(std::string directory);
+        static void Invalidate_(std::string path);
+        static void Watch_(std::string path);
+        static void WatchWork_();
+
+        static std::mutex mutex_;
+        static std::map<std::string, Ptr> assets_;
+        static std::map<std::string, Validator> validators_;
+        static std::map<int, std::string> watches_;
+        static std::thread watcher_;
+        static bool enabled_;
+        static bool running_;
+        static int inotify_fd_;
+        static std::string directory_;
+        static std::string immutable_directory_;
+        static unsigned long long generation_;
+        static std::size_t bytes_;
+        static std::size_t max_bytes_;
+        static std::size_t max_file_bytes_;
+        static std::size_t gzip_min_bytes_;
+        static std::size_t max_validators_;
+};
+
+#endif //STRUCTBX_TOOLS_ASSETCACHE
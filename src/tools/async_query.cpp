@@ -0,0 +1,522 @@
+
+#include "tools/async_query.h"
+
+using namespace StructBX::Tools;
+
+std::mutex AsyncQuery::mutex_;
+std::deque<std::unique_ptr<AsyncQuery::Request>> AsyncQuery::queue_;
+std::vector<std::unique_ptr<AsyncQuery::Connection>> AsyncQuery::connections_;
+std::thread AsyncQuery::loop_;
+bool AsyncQuery::running_ = false;
+int AsyncQuery::epoll_fd_ = -1;
+int AsyncQuery::event_fd_ = -1;
+std::size_t AsyncQuery::size_ = 0;
+std::string AsyncQuery::host_ = "127.0.0.1";
+std::string AsyncQuery::user_ = "root";
+std::string AsyncQuery::password_ = "";
+std::string AsyncQuery::database_ = "structbi";
+unsigned int AsyncQuery::port_ = 3306;
+
+void AsyncQuery::Start_()
+{
+    // Settings
+    try
+    {
+        size_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("db_async_connections", "0"));
+        port_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("db_port", "3306"));
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("AsyncQuery: db_async_connections and db_port must be integers");
+    }
+    host_ = NAF::Tools::SettingsManager::GetSetting_("db_host", "127.0.0.1");
+    user_ = NAF::Tools::SettingsManager::GetSetting_("db_user", "root");
+    password_ = NAF::Tools::SettingsManager::GetSetting_("db_password", "");
+    database_ = NAF::Tools::SettingsManager::GetSetting_("db_name", "structbi");
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(running_ || size_ == 0)
+        return;
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(epoll_fd_ < 0 || event_fd_ < 0)
+    {
+        NAF::Tools::OutputLogger::Error_("AsyncQuery: epoll is not available, queries run on the request threads");
+        if(epoll_fd_ >= 0)
+            close(epoll_fd_);
+        if(event_fd_ >= 0)
+            close(event_fd_);
+        epoll_fd_ = event_fd_ = -1;
+        return;
+    }
+
+    // The event fd wakes the loop up on new requests
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &event);
+
+    for(std::size_t i = 0; i < size_; ++i)
+        connections_.push_back(std::make_unique<Connection>());
+
+    running_ = true;
+    loop_ = std::thread(&AsyncQuery::Loop_);
+}
+
+void AsyncQuery::Stop_()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(!running_)
+            return;
+        running_ = false;
+    }
+    uint64_t one = 1;
+    if(write(event_fd_, &one, sizeof(one)) < 0)
+        NAF::Tools::OutputLogger::Debug_("AsyncQuery: Could not wake up the loop");
+    if(loop_.joinable())
+        loop_.join();
+
+    close(epoll_fd_);
+    close(event_fd_);
+    epoll_fd_ = event_fd_ = -1;
+    connections_.clear();
+}
+
+bool AsyncQuery::Enabled_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return running_;
+}
+
+void AsyncQuery::Submit_(std::string sql, std::vector<Poco::Nullable<std::string>> values, Callback callback)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(running_)
+        {
+            queue_.push_back(std::unique_ptr<Request>(new Request{sql, std::move(values), callback}));
+            lock.unlock();
+
+            uint64_t one = 1;
+            if(write(event_fd_, &one, sizeof(one)) < 0)
+                NAF::Tools::OutputLogger::Debug_("AsyncQuery: Could not wake up the loop");
+            return;
+        }
+    }
+
+    Result result;
+    result.error = "AsyncQuery is not running";
+    callback(result);
+}
+
+std::future<bool> AsyncQuery::Work_(Functions::Action::Ptr action)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+    auto future = promise->get_future();
+
+    // Verify and bind values, empty values are NULL
+    std::vector<Poco::Nullable<std::string>> values;
+    values.reserve(action->get_parameters().size());
+    for(auto& param : action->get_parameters())
+    {
+        if(!param->VerifyCondition_())
+        {
+            action->set_custom_error(param->get_error());
+            promise->set_value(false);
+            return future;
+        }
+
+        if(param->get_value()->TypeIsIqual_(NAF::Tools::DValue::Type::kEmpty))
+            values.push_back(Poco::Nullable<std::string>());
+        else
+            values.push_back(Poco::Nullable<std::string>(param->get_value()->ToString_()));
+    }
+
+    Submit_(action->get_sql_code(), std::move(values), [action, promise](Result& result)
+    {
+        if(!result.ok)
+        {
+            NAF::Tools::OutputLogger::Error_("AsyncQuery (" + action->get_identifier() + "): " + result.error);
+            action->set_custom_error("No se pudo completar la operaci&oacute;n");
+            promise->set_value(false);
+            return;
+        }
+
+        // Rows and JSON result, in the same shape that NAF leaves them
+        action->get_results()->clear();
+        for(auto& values : result.rows)
+        {
+            auto row = std::make_shared<NAF::Query::Row>();
+            for(std::size_t column = 0; column < result.columns.size(); ++column)
+                row->AddField_(result.columns[column], Value_(result, column, values[column]));
+            action->get_results()->push_back(row);
+        }
+        action->CreateJSONResult_();
+        promise->set_value(true);
+    });
+
+    return future;
+}
+
+void AsyncQuery::Loop_()
+{
+    mysql_thread_init();
+    for(auto& connection : connections_)
+        Connect_(*connection);
+
+    struct epoll_event events[64];
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if(!running_)
+                break;
+        }
+
+        // Queries are driven by epoll, only connects and unwatched sockets are polled
+        int timeout = -1;
+        for(auto& connection : connections_)
+        {
+            if(connection->stage == Stage::kConnecting || (connection->stage != Stage::kBroken && connection->events == 0))
+                timeout = 10;
+            else if(connection->stage == Stage::kBroken && timeout < 0)
+                timeout = 1000;
+        }
+
+        auto count = epoll_wait(epoll_fd_, events, 64, timeout);
+        for(int i = 0; i < count; ++i)
+        {
+            if(events[i].data.ptr == nullptr)
+            {
+                uint64_t value;
+                while(read(event_fd_, &value, sizeof(value)) > 0);
+                continue;
+            }
+
+            // An idle connection that becomes readable was closed by the server
+            auto connection = static_cast<Connection*>(events[i].data.ptr);
+            if(connection->stage == Stage::kIdle)
+            {
+                if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                {
+                    Close_(*connection);
+                    Connect_(*connection);
+                }
+            }
+            else
+                Advance_(*connection);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for(auto& connection : connections_)
+        {
+            if(connection->stage == Stage::kConnecting || (connection->stage != Stage::kBroken && connection->events == 0))
+                Advance_(*connection);
+            else if(connection->stage == Stage::kBroken && now >= connection->retry_at)
+                Connect_(*connection);
+        }
+
+        Dispatch_();
+        for(auto& connection : connections_)
+            Watch_(*connection);
+    }
+
+    // Nothing more will run, fail what is left
+    std::deque<std::unique_ptr<Request>> pending;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        pending.swap(queue_);
+    }
+    for(auto& connection : connections_)
+    {
+        if(connection->request)
+            pending.push_back(std::move(connection->request));
+        Close_(*connection);
+    }
+    for(auto& request : pending)
+    {
+        Result result;
+        result.error = "AsyncQuery stopped";
+        request->callback(result);
+    }
+    mysql_thread_end();
+}
+
+void AsyncQuery::Connect_(Connection& connection)
+{
+    connection.mysql = mysql_init(nullptr);
+    if(connection.mysql == nullptr)
+    {
+        connection.stage = Stage::kBroken;
+        connection.retry_at = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        return;
+    }
+
+    connection.stage = Stage::kConnecting;
+    Advance_(connection);
+}
+
+void AsyncQuery::Advance_(Connection& connection)
+{
+    if(connection.stage == Stage::kConnecting)
+    {
+        auto status = mysql_real_connect_nonblocking(
+            connection.mysql, host_.c_str(), user_.c_str(), password_.c_str(), database_.c_str(), port_, nullptr, 0
+        );
+        if(status == NET_ASYNC_NOT_READY)
+            return;
+        if(status == NET_ASYNC_ERROR)
+        {
+            NAF::Tools::OutputLogger::Error_("AsyncQuery: " + std::string(mysql_error(connection.mysql)));
+            Close_(connection);
+            return;
+        }
+
+        connection.stage = Stage::kIdle;
+        connection.fd = connection.mysql->net.fd;
+        return;
+    }
+
+    if(connection.stage == Stage::kQuery)
+    {
+        auto status = mysql_real_query_nonblocking(connection.mysql, connection.query.data(), connection.query.size());
+        if(status == NET_ASYNC_NOT_READY)
+            return;
+        if(status == NET_ASYNC_ERROR)
+        {
+            Result result;
+            result.error = mysql_error(connection.mysql);
+            auto error = mysql_errno(connection.mysql);
+            Finish_(connection, result);
+
+            // Lost connections are opened again, SQL errors keep it
+            if(error == CR_SERVER_GONE_ERROR || error == CR_SERVER_LOST)
+                Close_(connection);
+            return;
+        }
+
+        connection.stage = Stage::kResult;
+    }
+
+    if(connection.stage == Stage::kResult)
+    {
+        MYSQL_RES* res = nullptr;
+        auto status = mysql_store_result_nonblocking(connection.mysql, &res);
+        if(status == NET_ASYNC_NOT_READY)
+            return;
+
+        Result result;
+        if(status == NET_ASYNC_ERROR || (res == nullptr && mysql_field_count(connection.mysql) != 0))
+        {
+            result.error = mysql_error(connection.mysql);
+            if(res != nullptr)
+                mysql_free_result(res);
+            Finish_(connection, result);
+            return;
+        }
+
+        result.ok = true;
+        if(res == nullptr)
+            result.affected_rows = mysql_affected_rows(connection.mysql);
+        else
+        {
+            // The result is stored, fetching does not touch the socket
+            auto columns = mysql_num_fields(res);
+            auto fields = mysql_fetch_fields(res);
+            for(unsigned int column = 0; column < columns; ++column)
+            {
+                auto type = fields[column].type;
+                result.columns.push_back(fields[column].name);
+                result.integers.push_back(
+                    type == MYSQL_TYPE_TINY || type == MYSQL_TYPE_SHORT || type == MYSQL_TYPE_LONG ||
+                    type == MYSQL_TYPE_INT24 || type == MYSQL_TYPE_LONGLONG
+                );
+                result.decimals.push_back(
+                    type == MYSQL_TYPE_DECIMAL || type == MYSQL_TYPE_NEWDECIMAL || type == MYSQL_TYPE_FLOAT || type == MYSQL_TYPE_DOUBLE
+                );
+            }
+
+            MYSQL_ROW row;
+            while((row = mysql_fetch_row(res)) != nullptr)
+            {
+                auto lengths = mysql_fetch_lengths(res);
+                std::vector<Poco::Nullable<std::string>> values;
+                values.reserve(columns);
+                for(unsigned int column = 0; column < columns; ++column)
+                {
+                    if(row[column] == nullptr)
+                        values.push_back(Poco::Nullable<std::string>());
+                    else
+                        values.push_back(Poco::Nullable<std::string>(std::string(row[column], lengths[column])));
+                }
+                result.rows.push_back(std::move(values));
+            }
+            mysql_free_result(res);
+        }
+
+        Finish_(connection, result);
+    }
+}
+
+void AsyncQuery::Dispatch_()
+{
+    for(auto& connection : connections_)
+    {
+        while(connection->stage == Stage::kIdle)
+        {
+            std::unique_ptr<Request> request;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if(queue_.empty())
+                    return;
+                request = std::move(queue_.front());
+                queue_.pop_front();
+            }
+
+            connection->request = std::move(request);
+            if(!Bind_(connection->mysql, connection->request->sql, connection->request->values, connection->query))
+            {
+                Result result;
+                result.error = "The values could not be bound to the placeholders";
+                Finish_(*connection, result);
+                continue;
+            }
+
+            connection->stage = Stage::kQuery;
+            Advance_(*connection);
+        }
+    }
+}
+
+void AsyncQuery::Finish_(Connection& connection, Result& result)
+{
+    auto request = std::move(connection.request);
+    connection.query.clear();
+    if(connection.stage != Stage::kBroken)
+        connection.stage = Stage::kIdle;
+
+    if(!request)
+        return;
+
+    try
+    {
+        request->callback(result);
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Error_("AsyncQuery: " + std::string(e.what()));
+    }
+}
+
+void AsyncQuery::Watch_(Connection& connection)
+{
+    if(connection.fd < 0 || connection.stage == Stage::kConnecting || connection.stage == Stage::kBroken)
+        return;
+
+    // Idle connections wait level triggered for the server closing them, a query in
+    // progress is advanced on each edge of either direction since it sends and reads
+    uint32_t events = connection.stage == Stage::kIdle ? EPOLLIN : EPOLLIN | EPOLLOUT | EPOLLET;
+    if(events == connection.events)
+        return;
+
+    struct epoll_event event = {};
+    event.events = events;
+    event.data.ptr = &connection;
+    if(epoll_ctl(epoll_fd_, connection.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, connection.fd, &event) < 0)
+    {
+        NAF::Tools::OutputLogger::Error_("AsyncQuery: Could not watch a connection, it will be polled");
+        return;
+    }
+    connection.events = events;
+}
+
+void AsyncQuery::Close_(Connection& connection)
+{
+    if(connection.fd >= 0 && connection.events != 0)
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+    if(connection.mysql != nullptr)
+        mysql_close(connection.mysql);
+
+    connection.mysql = nullptr;
+    connection.fd = -1;
+    connection.events = 0;
+    connection.stage = Stage::kBroken;
+    connection.retry_at = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+}
+
+bool AsyncQuery::Bind_(MYSQL* mysql, std::string& sql, std::vector<Poco::Nullable<std::string>>& values, std::string& query)
+{
+    // Placeholders inside quotes and identifiers are text
+    query.clear();
+    query.reserve(sql.size());
+    std::size_t next = 0;
+    char quote = 0;
+    for(std::size_t i = 0; i < sql.size(); ++i)
+    {
+        auto character = sql[i];
+        if(quote != 0)
+        {
+            query += character;
+            if(character == '\\' && quote != '`' && i + 1 < sql.size())
+                query += sql[++i];
+            else if(character == quote)
+                quote = 0;
+            continue;
+        }
+        if(character == '\'' || character == '"' || character == '`')
+        {
+            quote = character;
+            query += character;
+            continue;
+        }
+        if(character != '?')
+        {
+            query += character;
+            continue;
+        }
+
+        if(next >= values.size())
+            return false;
+
+        // Values are sent as strings, MySQL converts them where a number is expected
+        auto& value = values[next++];
+        if(value.isNull())
+        {
+            query += "NULL";
+            continue;
+        }
+        // Escaped for single quotes, which also works with NO_BACKSLASH_ESCAPES
+        std::vector<char> escaped(value.value().size() * 2 + 1);
+        auto length = mysql_real_escape_string_quote(mysql, escaped.data(), value.value().data(), value.value().size(), '\'');
+        if(length == static_cast<unsigned long>(-1))
+            return false;
+        query += '\'';
+        query.append(escaped.data(), length);
+        query += '\'';
+    }
+
+    return next == values.size();
+}
+
+NAF::Tools::DValue::Ptr AsyncQuery::Value_(Result& result, std::size_t column, Poco::Nullable<std::string>& value)
+{
+    if(value.isNull())
+        return NAF::Tools::DValue::Ptr(new NAF::Tools::DValue());
+
+    try
+    {
+        if(result.integers[column])
+        {
+            auto number = std::stoll(value.value());
+            if(number == static_cast<int>(number))
+                return NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(static_cast<int>(number)));
+        }
+        else if(result.decimals[column])
+            return NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(std::stof(value.value())));
+    }
+    catch(std::exception&){}
+
+    return NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(value.value()));
+}
@@ -0,0 +1,125 @@
+
+#ifndef STRUCTBX_TOOLS_ASYNCQUERY
+#define STRUCTBX_TOOLS_ASYNCQUERY
+
+#include <list>
+#include <mutex>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <future>
+#include <functional>
+
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <mysql/mysql.h>
+#include <mysql/errmsg.h>
+
+#include "Poco/Nullable.h"
+
+#include "core/nebula_atom.h"
+#include "functions/action.h"
+#include <query/parameter.h>
+#include <tools/output_logger.h>
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class AsyncQuery;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+// Queries on the primary multiplexed over a few connections by one epoll thread,
+// a waiting query holds no thread
+class StructBX::Tools::AsyncQuery
+{
+    public:
+        struct Result
+        {
+            bool ok = false;
+            std::string error;
+            std::vector<std::string> columns;
+            std::vector<bool> integers;
+            std::vector<bool> decimals;
+            std::vector<std::vector<Poco::Nullable<std::string>>> rows;
+            unsigned long long affected_rows = 0;
+        };
+
+        using Callback = std::function<void(Result&)>;
+
+        static void Start_();
+        static void Stop_();
+
+        // False when db_async_connections is 0, the default, or the loop could not start
+        static bool Enabled_();
+
+        // Values replace the ? placeholders escaped and quoted, the callback runs
+        // on the event loop and must not block
+        static void Submit_(std::string sql, std::vector<Poco::Nullable<std::string>> values, Callback callback);
+
+        // Verifies the parameters and leaves the rows and the JSON result in the action,
+        // for actions without action conditions since those are verified by NAF
+        static std::future<bool> Work_(Functions::Action::Ptr action);
+
+    private:
+        enum class Stage
+        {
+            kConnecting
+            ,kIdle
+            ,kQuery
+            ,kResult
+            ,kBroken
+        };
+
+        struct Request
+        {
+            std::string sql;
+            std::vector<Poco::Nullable<std::string>> values;
+            Callback callback;
+        };
+
+        struct Connection
+        {
+            MYSQL* mysql = nullptr;
+            Stage stage = Stage::kBroken;
+            int fd = -1;
+            uint32_t events = 0;
+            std::string query;
+            std::unique_ptr<Request> request;
+            std::chrono::steady_clock::time_point retry_at;
+        };
+
+        static void Loop_();
+        static void Connect_(Connection& connection);
+        static void Advance_(Connection& connection);
+        static void Dispatch_();
+        static void Finish_(Connection& connection, Result& result);
+        static void Watch_(Connection& connection);
+        static void Close_(Connection& connection);
+        static bool Bind_(MYSQL* mysql, std::string& sql, std::vector<Poco::Nullable<std::string>>& values, std::string& query);
+        static NAF::Tools::DValue::Ptr Value_(Result& result, std::size_t column, Poco::Nullable<std::string>& value);
+
+        static std::mutex mutex_;
+        static std::deque<std::unique_ptr<Request>> queue_;
+        static std::vector<std::unique_ptr<Connection>> connections_;
+        static std::thread loop_;
+        static bool running_;
+        static int epoll_fd_;
+        static int event_fd_;
+        static std::size_t size_;
+        static std::string host_;
+        static std::string user_;
+        static std::string password_;
+        static std::string database_;
+        static unsigned int port_;
+};
+
+#endif //STRUCTBX_TOOLS_ASYNCQUERY
@@ -0,0 +1,72 @@
+
+#ifndef STRUCTBX_TOOLS_BOUNDEDQUEUE
+#define STRUCTBX_TOOLS_BOUNDEDQUEUE
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        template <typename T> class BoundedQueue;
+    }
+}
+
+using namespace StructBX;
+
+template <typename T>
+class StructBX::Tools::BoundedQueue
+{
+    public:
+        BoundedQueue(std::size_t capacity) :
+            capacity_(capacity < 1 ? 1 : capacity)
+            ,closed_(false)
+        {}
+
+        // Blocks while the queue is full, returns false if the queue was closed
+        bool Push_(T element)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_.wait(lock, [this]{ return closed_ || elements_.size() < capacity_; });
+            if(closed_)
+                return false;
+
+            elements_.push_back(std::move(element));
+            not_empty_.notify_one();
+            return true;
+        }
+
+        // Blocks while the queue is empty, returns false if it was closed and drained
+        bool Pop_(T& element)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this]{ return closed_ || !elements_.empty(); });
+            if(elements_.empty())
+                return false;
+
+            element = std::move(elements_.front());
+            elements_.pop_front();
+            not_full_.notify_one();
+            return true;
+        }
+
+        void Close_()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            closed_ = true;
+            not_empty_.notify_all();
+            not_full_.notify_all();
+        }
+
+    private:
+        std::size_t capacity_;
+        bool closed_;
+        std::deque<T> elements_;
+        std::mutex mutex_;
+        std::condition_variable not_empty_;
+        std::condition_variable not_full_;
+};
+
+#endif //STRUCTBX_TOOLS_BOUNDEDQUEUE
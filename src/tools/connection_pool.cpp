@@ -0,0 +1,333 @@
+
+#include "tools/connection_pool.h"
+
+using namespace StructBX::Tools;
+
+std::mutex ConnectionPool::mutex_;
+std::map<std::string, std::shared_ptr<ConnectionPool::Endpoint>> ConnectionPool::endpoints_;
+std::vector<std::string> ConnectionPool::replicas_;
+std::atomic<unsigned int> ConnectionPool::next_replica_(0);
+std::size_t ConnectionPool::min_sessions_ = 1;
+std::size_t ConnectionPool::max_sessions_ = 32;
+std::chrono::milliseconds ConnectionPool::wait_(2000);
+std::chrono::seconds ConnectionPool::ping_after_(30);
+std::chrono::seconds ConnectionPool::idle_time_(60);
+
+ConnectionPool::Lease::Lease(std::shared_ptr<Endpoint> endpoint, std::shared_ptr<Slot> slot) :
+    endpoint_(endpoint)
+    ,slot_(slot)
+{
+
+}
+
+ConnectionPool::Lease::Lease(Lease&& other) :
+    endpoint_(std::move(other.endpoint_))
+    ,slot_(std::move(other.slot_))
+{
+
+}
+
+ConnectionPool::Lease::~Lease()
+{
+    if(!slot_ || !endpoint_)
+        return;
+
+    // Sessions idle for too long are closed outside the lock
+    std::list<std::shared_ptr<Slot>> expired;
+    {
+        std::unique_lock<std::mutex> lock(endpoint_->mutex);
+        bool connected = false;
+        try
+        {
+            connected = slot_->session.isConnected();
+        }
+        catch(std::exception&){}
+
+        if(endpoint_->running && connected)
+        {
+            slot_->last_used = std::chrono::steady_clock::now();
+            endpoint_->idle.push_back(slot_);
+        }
+        else
+            endpoint_->size--;
+
+        auto now = std::chrono::steady_clock::now();
+        while(endpoint_->size > min_sessions_ && !endpoint_->idle.empty() && now - endpoint_->idle.front()->last_used > idle_time_)
+        {
+            expired.push_back(endpoint_->idle.front());
+            endpoint_->idle.pop_front();
+            endpoint_->size--;
+        }
+    }
+    endpoint_->available.notify_one();
+}
+
+void ConnectionPool::Start_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(!endpoints_.empty())
+        return;
+
+    // Settings
+    try
+    {
+        min_sessions_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("db_pool_min", "1"));
+        max_sessions_ = std::max<std::size_t>(1, std::stoul(NAF::Tools::SettingsManager::GetSetting_("db_pool_max", "32")));
+        idle_time_ = std::chrono::seconds(std::stoi(NAF::Tools::SettingsManager::GetSetting_("db_pool_idle_time", "60")));
+        wait_ = std::chrono::milliseconds(std::stoi(NAF::Tools::SettingsManager::GetSetting_("db_pool_wait_ms", "2000")));
+        ping_after_ = std::chrono::seconds(std::stoi(NAF::Tools::SettingsManager::GetSetting_("db_pool_ping_after", "30")));
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("ConnectionPool: db_pool_min, db_pool_max, db_pool_idle_time, db_pool_wait_ms and db_pool_ping_after must be integers");
+    }
+
+    Poco::Data::MySQL::Connector::registerConnector();
+
+    // Primary
+    Add_("", NAF::Tools::SettingsManager::GetSetting_("db_host", "127.0.0.1"), NAF::Tools::SettingsManager::GetSetting_("db_port", "3306"));
+
+    // Shards: "name=host:port,name=host:port", same database and credentials as the primary
+    std::stringstream shards(NAF::Tools::SettingsManager::GetSetting_("db_shards", ""));
+    std::string shard;
+    while(std::getline(shards, shard, ','))
+    {
+        auto equal = shard.find('=');
+        auto colon = shard.rfind(':');
+        if(equal == std::string::npos || colon == std::string::npos || colon < equal)
+        {
+            NAF::Tools::OutputLogger::Error_("ConnectionPool: Invalid shard \"" + shard + "\", expected name=host:port");
+            continue;
+        }
+
+        Add_(shard.substr(0, equal), shard.substr(equal + 1, colon - equal - 1), shard.substr(colon + 1));
+    }
+
+    // Replicas of the primary: "host:port,host:port"
+    std::stringstream replicas(NAF::Tools::SettingsManager::GetSetting_("db_replicas", ""));
+    std::string replica;
+    while(std::getline(replicas, replica, ','))
+    {
+        auto colon = replica.rfind(':');
+        if(colon == std::string::npos)
+        {
+            NAF::Tools::OutputLogger::Error_("ConnectionPool: Invalid replica \"" + replica + "\", expected host:port");
+            continue;
+        }
+
+        auto name = "replica/" + std::to_string(replicas_.size());
+        Add_(name, replica.substr(0, colon), replica.substr(colon + 1));
+        replicas_.push_back(name);
+    }
+}
+
+void ConnectionPool::Stop_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for(auto& it : endpoints_)
+    {
+        auto& endpoint = *it.second;
+        {
+            std::unique_lock<std::mutex> endpoint_lock(endpoint.mutex);
+            endpoint.running = false;
+            endpoint.size -= endpoint.idle.size();
+            endpoint.idle.clear();
+        }
+        endpoint.available.notify_all();
+    }
+    endpoints_.clear();
+    replicas_.clear();
+}
+
+ConnectionPool::Lease ConnectionPool::Get_(std::string endpoint)
+{
+    std::shared_ptr<Endpoint> target;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto found = endpoints_.find(endpoint);
+        if(found == endpoints_.end())
+            throw Poco::IllegalStateException("ConnectionPool: endpoint \"" + endpoint + "\" is not started");
+        target = found->second;
+    }
+
+    // Session used last by this thread, its caches are warm
+    thread_local std::map<Endpoint*, std::weak_ptr<Slot>> affinity;
+
+    auto start = std::chrono::steady_clock::now();
+    bool waited = false;
+    std::unique_lock<std::mutex> lock(target->mutex);
+    target->checkouts++;
+    while(true)
+    {
+        if(!target->running)
+            throw Poco::IllegalStateException("ConnectionPool: endpoint \"" + endpoint + "\" is stopped");
+
+        std::shared_ptr<Slot> slot;
+        bool created = false;
+        if(!target->idle.empty())
+        {
+            auto preferred = affinity[target.get()].lock();
+            auto it = preferred ? std::find(target->idle.begin(), target->idle.end(), preferred) : target->idle.end();
+            if(it == target->idle.end())
+                it = std::prev(target->idle.end());
+            slot = *it;
+            target->idle.erase(it);
+        }
+        else if(target->size < max_sessions_)
+        {
+            target->size++;
+            created = true;
+        }
+        else
+        {
+            // Bounded, wait for a session to come back
+            waited = true;
+            if(target->available.wait_until(lock, start + wait_) == std::cv_status::timeout && target->idle.empty() && target->size >= max_sessions_)
+            {
+                target->timeouts++;
+                throw Poco::Data::SessionPoolExhaustedException("ConnectionPool: no session available on endpoint \"" + endpoint + "\"");
+            }
+            continue;
+        }
+
+        // Connect or check the session without holding the lock
+        lock.unlock();
+        if(created)
+        {
+            try
+            {
+                slot = std::make_shared<Slot>(Poco::Data::Session(Poco::Data::MySQL::Connector::KEY, target->connection_string));
+            }
+            catch(...)
+            {
+                lock.lock();
+                target->size--;
+                lock.unlock();
+                target->available.notify_one();
+                throw;
+            }
+        }
+        else if(std::chrono::steady_clock::now() - slot->last_used > ping_after_ && !Ping_(slot->session))
+        {
+            lock.lock();
+            target->failed_pings++;
+            target->size--;
+            continue;
+        }
+
+        // Wait metrics
+        lock.lock();
+        if(waited)
+        {
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+            target->waits++;
+            target->wait_total += elapsed;
+            target->wait_max = std::max(target->wait_max, elapsed);
+        }
+        lock.unlock();
+
+        affinity[target.get()] = slot;
+        return Lease(target, slot);
+    }
+}
+
+std::list<std::string> ConnectionPool::Endpoints_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::list<std::string> endpoints;
+    for(auto& it : endpoints_)
+    {
+        if(it.first != "" && it.first.compare(0, 8, "replica/") != 0)
+            endpoints.push_back(it.first);
+    }
+
+    return endpoints;
+}
+
+std::string ConnectionPool::Replica_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(replicas_.empty())
+        return "";
+
+    return replicas_[next_replica_++ % replicas_.size()];
+}
+
+Poco::JSON::Object::Ptr ConnectionPool::Metrics_()
+{
+    Poco::JSON::Object::Ptr metrics = new Poco::JSON::Object;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for(auto& it : endpoints_)
+    {
+        auto& endpoint = *it.second;
+        std::unique_lock<std::mutex> endpoint_lock(endpoint.mutex);
+
+        Poco::JSON::Object::Ptr object = new Poco::JSON::Object;
+        object->set("size", endpoint.size);
+        object->set("idle", endpoint.idle.size());
+        object->set("checkouts", endpoint.checkouts);
+        object->set("waits", endpoint.waits);
+        object->set("timeouts", endpoint.timeouts);
+        object->set("failed_pings", endpoint.failed_pings);
+        object->set("wait_average_ms", endpoint.waits == 0 ? 0.0 : endpoint.wait_total.count() / 1000.0 / endpoint.waits);
+        object->set("wait_max_ms", endpoint.wait_max.count() / 1000.0);
+        metrics->set(it.first == "" ? "primary" : it.first, object);
+    }
+
+    return metrics;
+}
+
+void ConnectionPool::Add_(std::string name, std::string host, std::string port)
+{
+    auto endpoint = std::make_shared<Endpoint>();
+    endpoint->connection_string = ConnectionString_(host, port);
+    endpoints_[name] = endpoint;
+
+    // Warm up, the first requests don't pay for the connections
+    for(std::size_t i = 0; i < min_sessions_ && i < max_sessions_; ++i)
+    {
+        try
+        {
+            auto slot = std::make_shared<Slot>(Poco::Data::Session(Poco::Data::MySQL::Connector::KEY, endpoint->connection_string));
+            if(!Ping_(slot->session))
+                break;
+            slot->last_used = std::chrono::steady_clock::now();
+            endpoint->idle.push_back(slot);
+            endpoint->size++;
+        }
+        catch(std::exception& e)
+        {
+            NAF::Tools::OutputLogger::Error_("ConnectionPool: Could not warm up endpoint \"" + name + "\": " + std::string(e.what()));
+            break;
+        }
+    }
+}
+
+std::string ConnectionPool::ConnectionString_(std::string host, std::string port)
+{
+    return
+        "host=" + host +
+        ";port=" + port +
+        ";db=" + NAF::Tools::SettingsManager::GetSetting_("db_name", "structbi") +
+        ";user=" + NAF::Tools::SettingsManager::GetSetting_("db_user", "root") +
+        ";password=" + NAF::Tools::SettingsManager::GetSetting_("db_password", "") +
+        ";compress=true;auto-reconnect=true"
+    ;
+}
+
+bool ConnectionPool::Ping_(Poco::Data::Session& session)
+{
+    try
+    {
+        int one = 0;
+        Poco::Data::Statement statement(session);
+        statement << "SELECT 1", Poco::Data::Keywords::into(one), Poco::Data::Keywords::now;
+        return one == 1;
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Debug_("ConnectionPool: " + std::string(e.what()));
+        return false;
+    }
+}
@@ -0,0 +1,124 @@
+
+#ifndef STRUCTBX_TOOLS_CONNECTIONPOOL
+#define STRUCTBX_TOOLS_CONNECTIONPOOL
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <condition_variable>
+
+#include "Poco/Data/Session.h"
+#include "Poco/Data/Statement.h"
+#include "Poco/Data/DataException.h"
+#include "Poco/Exception.h"
+#include "Poco/Data/MySQL/Connector.h"
+#include "Poco/JSON/Object.h"
+
+#include "core/nebula_atom.h"
+#include <tools/output_logger.h>
+
+#include "tools/statement_cache.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class ConnectionPool;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+// Sessions of the background tools and of every action run through RoutedAction,
+// db_pool_max bounds those. Endpoint actions still run by NAF use its own sessions
+class StructBX::Tools::ConnectionPool
+{
+    private:
+        struct Slot
+        {
+            Slot(Poco::Data::Session session) : session(session) {}
+
+            Poco::Data::Session session;
+            StatementCache statements;
+            std::chrono::steady_clock::time_point last_used;
+        };
+
+        struct Endpoint
+        {
+            std::string connection_string;
+            std::mutex mutex;
+            std::condition_variable available;
+            std::list<std::shared_ptr<Slot>> idle;
+            std::size_t size = 0;
+            bool running = true;
+
+            // Metrics
+            unsigned long long checkouts = 0;
+            unsigned long long waits = 0;
+            unsigned long long timeouts = 0;
+            unsigned long long failed_pings = 0;
+            std::chrono::microseconds wait_total{0};
+            std::chrono::microseconds wait_max{0};
+        };
+
+    public:
+        // A session borrowed from the pool, returned when destroyed
+        class Lease
+        {
+            public:
+                Lease(std::shared_ptr<Endpoint> endpoint, std::shared_ptr<Slot> slot);
+                Lease(Lease&& other);
+                Lease(const Lease&) = delete;
+                ~Lease();
+
+                Poco::Data::Session& operator*() { return slot_->session; }
+                Poco::Data::Session* operator->() { return &slot_->session; }
+
+                // Prepared statements of this session
+                StatementCache& Statements_() { return slot_->statements; }
+
+            private:
+                std::shared_ptr<Endpoint> endpoint_;
+                std::shared_ptr<Slot> slot_;
+        };
+
+        static void Start_();
+        static void Stop_();
+
+        // Waits up to db_pool_wait_ms for a free session, endpoint "" is the primary server from db_host
+        static Lease Get_(std::string endpoint = "");
+
+        // Names of the endpoints configured in db_shards
+        static std::list<std::string> Endpoints_();
+
+        // Next replica of the primary from db_replicas, "" if there are none
+        static std::string Replica_();
+
+        // Checkouts, waits and wait times per endpoint
+        static Poco::JSON::Object::Ptr Metrics_();
+
+    private:
+        static void Add_(std::string name, std::string host, std::string port);
+        static std::string ConnectionString_(std::string host, std::string port);
+        static bool Ping_(Poco::Data::Session& session);
+
+        static std::mutex mutex_;
+        static std::map<std::string, std::shared_ptr<Endpoint>> endpoints_;
+        static std::vector<std::string> replicas_;
+        static std::atomic<unsigned int> next_replica_;
+        static std::size_t min_sessions_;
+        static std::size_t max_sessions_;
+        static std::chrono::milliseconds wait_;
+        static std::chrono::seconds ping_after_;
+        static std::chrono::seconds idle_time_;
+};
+
+#endif //STRUCTBX_TOOLS_CONNECTIONPOOL
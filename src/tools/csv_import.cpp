@@ -0,0 +1,421 @@
+
+#include "tools/csv_import.h"
+
+using namespace StructBX::Tools;
+
+std::mutex CSVImport::imports_mutex_;
+std::map<std::string, CSVImport::Ptr> CSVImport::imports_;
+bool CSVImport::stopped_ = false;
+
+CSVImport::CSVImport(std::string filepath, std::string table, std::vector<Column> columns, char delimiter) :
+    id_(Poco::UUIDGenerator::defaultGenerator().createRandom().toString())
+    ,space_id_("")
+    ,filepath_(filepath)
+    ,table_(table)
+    ,columns_(columns)
+    ,delimiter_(delimiter)
+    ,batch_size_(500)
+    ,read_queue_(1000)
+    ,valid_queue_(1000)
+    ,pending_stages_(3)
+    ,state_(State::kRunning)
+    ,read_rows_(0)
+    ,inserted_rows_(0)
+    ,rejected_rows_(0)
+    ,error_("")
+    ,errors_(new Poco::JSON::Array)
+{
+    try
+    {
+        batch_size_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("bulk_insert_batch", "500"));
+    }
+    catch(std::exception&){NAF::Tools::OutputLogger::Error_("bulk_insert_batch setting is not an integer");}
+
+    // MySQL takes at most 65535 placeholders per statement
+    if(!columns_.empty())
+        batch_size_ = std::min<std::size_t>(batch_size_, 65535 / columns_.size());
+    if(batch_size_ < 1)
+        batch_size_ = 1;
+}
+
+CSVImport::~CSVImport()
+{
+    Join_();
+}
+
+CSVImport::Ptr CSVImport::Start_(Ptr import)
+{
+    static std::size_t max_running = [](){
+        try
+        {
+            return std::stoul(NAF::Tools::SettingsManager::GetSetting_("csv_import_max", "4"));
+        }
+        catch(std::exception&)
+        {
+            NAF::Tools::OutputLogger::Error_("CSVImport: csv_import_max must be an integer");
+            return 4ul;
+        }
+    }();
+
+    std::unique_lock<std::mutex> lock(imports_mutex_);
+    if(stopped_)
+        return nullptr;
+
+    // Forget imports finished more than an hour ago, their threads are done
+    auto now = std::chrono::steady_clock::now();
+    std::size_t running = 0;
+    for(auto it = imports_.begin(); it != imports_.end();)
+    {
+        std::unique_lock<std::mutex> errors_lock(it->second->errors_mutex_);
+        if(it->second->state_ == State::kRunning)
+            running++;
+        if(it->second->state_ != State::kRunning && now - it->second->finished_at_ > std::chrono::hours(1))
+        {
+            errors_lock.unlock();
+            it->second->Join_();
+            it = imports_.erase(it);
+        }
+        else
+            it++;
+    }
+    if(running >= max_running)
+        return nullptr;
+
+    imports_.insert(std::make_pair(import->get_id(), import));
+
+    // Each stage runs in its own thread, connected by bounded queues. The map keeps
+    // the import alive until its threads are joined
+    auto raw = import.get();
+    import->reader_ = std::thread([raw]{ raw->Read_(); });
+    import->validator_ = std::thread([raw]{ raw->Validate_(); });
+    import->writer_ = std::thread([raw]{ raw->Write_(); });
+
+    return import;
+}
+
+void CSVImport::Stop_()
+{
+    std::map<std::string, Ptr> imports;
+    {
+        std::unique_lock<std::mutex> lock(imports_mutex_);
+        stopped_ = true;
+        imports = imports_;
+    }
+
+    for(auto& it : imports)
+        it.second->Cancel_();
+    for(auto& it : imports)
+        it.second->Join_();
+}
+
+CSVImport::Ptr CSVImport::Find_(std::string id)
+{
+    std::unique_lock<std::mutex> lock(imports_mutex_);
+
+    auto found = imports_.find(id);
+    if(found == imports_.end())
+        return nullptr;
+
+    return found->second;
+}
+
+Poco::JSON::Object::Ptr CSVImport::Progress_()
+{
+    std::unique_lock<std::mutex> lock(errors_mutex_);
+
+    std::string state = "running";
+    if(state_ == State::kFinished)
+        state = "finished";
+    else if(state_ == State::kFailed)
+        state = "failed";
+
+    Poco::JSON::Object::Ptr progress = new Poco::JSON::Object;
+    progress->set("id", id_);
+    progress->set("state", state);
+    progress->set("read", static_cast<int>(read_rows_));
+    progress->set("inserted", static_cast<int>(inserted_rows_));
+    progress->set("rejected", static_cast<int>(rejected_rows_));
+    progress->set("error", error_);
+
+    // A copy, Reject_ keeps adding errors after the lock is released
+    Poco::JSON::Array::Ptr errors = new Poco::JSON::Array;
+    for(std::size_t i = 0; i < errors_->size(); i++)
+    {
+        auto row_error = errors_->getObject(i);
+        if(!row_error.isNull())
+            errors->add(Poco::JSON::Object::Ptr(new Poco::JSON::Object(*row_error)));
+    }
+    progress->set("errors", errors);
+    return progress;
+}
+
+void CSVImport::Read_()
+{
+    std::ifstream stream(filepath_, std::ios::binary);
+    if(!stream.is_open())
+    {
+        {
+            std::unique_lock<std::mutex> lock(errors_mutex_);
+            error_ = "No se pudo abrir el archivo";
+        }
+        state_ = State::kFailed;
+    }
+    else
+    {
+        // Header: map CSV columns to form columns by identifier or name
+        std::vector<std::string> fields;
+        if(ReadRecord_(stream, fields))
+        {
+            // Files saved by spreadsheets may start with a UTF-8 BOM
+            if(!fields.empty() && fields.front().compare(0, 3, "\xEF\xBB\xBF") == 0)
+                fields.front().erase(0, 3);
+
+            for(auto& field : fields)
+            {
+                int index = -1;
+                for(std::size_t i = 0; i < columns_.size(); i++)
+                {
+                    if(columns_[i].identifier == field || columns_[i].name == field)
+                    {
+                        index = i;
+                        break;
+                    }
+                }
+                header_map_.push_back(index);
+            }
+        }
+
+        // Rows
+        std::size_t row = 1;
+        while(state_ == State::kRunning && ReadRecord_(stream, fields))
+        {
+            row++;
+            if(fields.size() == 1 && fields.front() == "")
+                continue;
+
+            read_rows_++;
+            if(!read_queue_.Push_(Record{row, fields}))
+                break;
+        }
+    }
+
+    read_queue_.Close_();
+    Finish_();
+}
+
+void CSVImport::Validate_()
+{
+    Record record;
+    while(read_queue_.Pop_(record))
+    {
+        // Place every field in its form column, missing columns stay empty
+        std::vector<std::string> values(columns_.size(), "");
+        for(std::size_t i = 0; i < record.fields.size() && i < header_map_.size(); i++)
+        {
+            if(header_map_[i] != -1)
+                values[header_map_[i]] = record.fields[i];
+        }
+
+        // Verify with the same rules as a single record
+        bool valid = true;
+        ValidRecord valid_record{record.row, {}};
+        for(std::size_t i = 0; i < columns_.size(); i++)
+        {
+            auto param = Query::Parameter::Ptr(new Query::Parameter(columns_[i].identifier, NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(values[i])), false));
+            if(!columns_[i].verification(param))
+            {
+                Reject_(record.row, columns_[i].identifier, param->get_error());
+                valid = false;
+                break;
+            }
+            valid_record.parameters.push_back(param);
+        }
+
+        if(valid && !valid_queue_.Push_(valid_record))
+            break;
+    }
+
+    read_queue_.Close_();
+    valid_queue_.Close_();
+    Finish_();
+}
+
+void CSVImport::Write_()
+{
+    std::vector<ValidRecord> batch;
+    ValidRecord valid_record;
+    bool open = true;
+    while(open && state_ != State::kFailed)
+    {
+        open = valid_queue_.Pop_(valid_record);
+        if(open)
+            batch.push_back(valid_record);
+
+        if(batch.size() < batch_size_ && open)
+            continue;
+        if(batch.empty())
+            continue;
+
+        // Write the batch, if it fails insert its rows one by one to find the failed ones
+        if(Insert_(batch.begin(), batch.end()))
+            inserted_rows_ += batch.size();
+        else
+        {
+            for(auto it = batch.begin(); it != batch.end(); it++)
+            {
+                if(Insert_(it, it + 1))
+                    inserted_rows_++;
+                else
+                    Reject_(it->row, "", "No se pudo guardar el registro");
+            }
+        }
+        batch.clear();
+    }
+
+    valid_queue_.Close_();
+    Finish_();
+}
+
+void CSVImport::Cancel_()
+{
+    if(state_ == State::kRunning)
+    {
+        {
+            std::unique_lock<std::mutex> lock(errors_mutex_);
+            error_ = "La importaci&oacute;n se detuvo";
+        }
+        state_ = State::kFailed;
+    }
+
+    // Blocked stages wake up and leave
+    read_queue_.Close_();
+    valid_queue_.Close_();
+}
+
+void CSVImport::Join_()
+{
+    for(auto thread : {&reader_, &validator_, &writer_})
+    {
+        if(thread->joinable())
+            thread->join();
+    }
+}
+
+void CSVImport::Finish_()
+{
+    // Only the last stage finishes the import
+    if(--pending_stages_ > 0)
+        return;
+
+    try
+    {
+        Poco::File file(filepath_);
+        if(file.exists())
+            file.remove();
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Error_("CSVImport: " + std::string(e.what()));
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(errors_mutex_);
+        finished_at_ = std::chrono::steady_clock::now();
+    }
+    if(state_ == State::kRunning)
+        state_ = State::kFinished;
+
+    if(on_finish_)
+        on_finish_(*this);
+}
+
+bool CSVImport::ReadRecord_(std::istream& stream, std::vector<std::string>& fields)
+{
+    fields.clear();
+    if(stream.peek() == std::char_traits<char>::eof())
+        return false;
+
+    // RFC 4180: quoted fields may contain delimiters, new lines and "" escapes
+    std::string field = "";
+    bool quoted = false;
+    char c;
+    while(stream.get(c))
+    {
+        if(quoted)
+        {
+            if(c == '"')
+            {
+                if(stream.peek() == '"')
+                {
+                    stream.get(c);
+                    field += '"';
+                }
+                else
+                    quoted = false;
+            }
+            else
+                field += c;
+        }
+        else if(c == '"' && field == "")
+            quoted = true;
+        else if(c == delimiter_)
+        {
+            fields.push_back(field);
+            field = "";
+        }
+        else if(c == '\n')
+            break;
+        else if(c != '\r')
+            field += c;
+    }
+    fields.push_back(field);
+
+    return true;
+}
+
+bool CSVImport::Insert_(std::vector<ValidRecord>::iterator begin, std::vector<ValidRecord>::iterator end)
+{
+    std::string columns = "";
+    std::string values = "";
+    for(auto& column : columns_)
+    {
+        if(columns == "")
+        {
+            columns = "_structbx_column_" + column.id;
+            values = "?";
+        }
+        else
+        {
+            columns += ",_structbx_column_" + column.id;
+            values += ", ?";
+        }
+    }
+
+    auto action = NAF::Functions::Action("a1");
+    std::string rows_sql = "";
+    for(auto it = begin; it != end; it++)
+    {
+        rows_sql += (rows_sql == "" ? "(" : ", (") + values + ")";
+        for(auto& param : it->parameters)
+            action.AddParameter_(param->get_name(), param->get_value(), false);
+    }
+    action.set_sql_code("INSERT INTO " + table_ + " (" + columns + ") VALUES " + rows_sql);
+
+    return ShardMap::Prepared_(action, space_id_);
+}
+
+void CSVImport::Reject_(std::size_t row, std::string column, std::string error)
+{
+    rejected_rows_++;
+
+    // Keep the first errors only, the count is always reported
+    std::unique_lock<std::mutex> lock(errors_mutex_);
+    if(errors_->size() >= 100)
+        return;
+
+    Poco::JSON::Object::Ptr row_error = new Poco::JSON::Object;
+    row_error->set("row", static_cast<int>(row));
+    row_error->set("column", column);
+    row_error->set("error", error);
+    errors_->add(row_error);
+}
@@ -0,0 +1,131 @@
+
+#ifndef STRUCTBX_TOOLS_CSVIMPORT
+#define STRUCTBX_TOOLS_CSVIMPORT
+
+#include <map>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+
+#include "Poco/File.h"
+#include "Poco/UUIDGenerator.h"
+#include "Poco/JSON/Object.h"
+#include "Poco/JSON/Array.h"
+
+#include "core/nebula_atom.h"
+#include "functions/action.h"
+#include <query/parameter.h>
+#include <tools/output_logger.h>
+
+#include "tools/bounded_queue.h"
+#include "tools/shard_map.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class CSVImport;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::CSVImport
+{
+    public:
+        using Ptr = std::shared_ptr<CSVImport>;
+        using Verification = std::function<bool(Query::Parameter::Ptr)>;
+
+        enum class State {kRunning, kFinished, kFailed};
+
+        struct Column
+        {
+            std::string id;
+            std::string identifier;
+            std::string name;
+            Verification verification;
+        };
+
+        CSVImport(std::string filepath, std::string table, std::vector<Column> columns, char delimiter);
+        ~CSVImport();
+
+        std::string get_id() const { return id_; }
+        std::string get_space_id() const { return space_id_; }
+        State get_state() const { return state_; }
+
+        void set_space_id(std::string space_id){ space_id_ = space_id; }
+        void set_on_finish(std::function<void(CSVImport&)> on_finish){ on_finish_ = on_finish; }
+
+        // Null when csv_import_max imports are already running or imports were stopped
+        static Ptr Start_(Ptr import);
+        static Ptr Find_(std::string id);
+
+        // Cancels the running imports and waits for their threads
+        static void Stop_();
+
+        Poco::JSON::Object::Ptr Progress_();
+
+    protected:
+        struct Record
+        {
+            std::size_t row;
+            std::vector<std::string> fields;
+        };
+        struct ValidRecord
+        {
+            std::size_t row;
+            std::vector<Query::Parameter::Ptr> parameters;
+        };
+
+        void Read_();
+        void Validate_();
+        void Write_();
+        void Finish_();
+        void Cancel_();
+        void Join_();
+
+        bool ReadRecord_(std::istream& stream, std::vector<std::string>& fields);
+        bool Insert_(std::vector<ValidRecord>::iterator begin, std::vector<ValidRecord>::iterator end);
+        void Reject_(std::size_t row, std::string column, std::string error);
+
+    private:
+        std::string id_;
+        std::string space_id_;
+        std::string filepath_;
+        std::string table_;
+        std::vector<Column> columns_;
+        std::vector<int> header_map_;
+        char delimiter_;
+        std::size_t batch_size_;
+        std::function<void(CSVImport&)> on_finish_;
+
+        BoundedQueue<Record> read_queue_;
+        BoundedQueue<ValidRecord> valid_queue_;
+        std::atomic<int> pending_stages_;
+
+        std::atomic<State> state_;
+        std::atomic<std::size_t> read_rows_;
+        std::atomic<std::size_t> inserted_rows_;
+        std::atomic<std::size_t> rejected_rows_;
+        std::mutex errors_mutex_;
+        std::string error_;
+        Poco::JSON::Array::Ptr errors_;
+        std::chrono::steady_clock::time_point finished_at_;
+        std::thread reader_;
+        std::thread validator_;
+        std::thread writer_;
+
+        static std::mutex imports_mutex_;
+        static std::map<std::string, Ptr> imports_;
+        static bool stopped_;
+};
+
+#endif //STRUCTBX_TOOLS_CSVIMPORT
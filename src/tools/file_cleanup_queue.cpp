@@ -0,0 +1,217 @@
+
+#include "tools/file_cleanup_queue.h"
+
+using namespace StructBX::Tools;
+
+std::mutex FileCleanupQueue::mutex_;
+std::list<FileCleanupQueue::Entry> FileCleanupQueue::entries_;
+std::condition_variable FileCleanupQueue::condition_;
+std::thread FileCleanupQueue::worker_;
+bool FileCleanupQueue::running_ = false;
+std::string FileCleanupQueue::journal_ = "structbx_file_cleanup.journal";
+int FileCleanupQueue::interval_ = 1000;
+std::size_t FileCleanupQueue::batch_size_ = 100;
+int FileCleanupQueue::max_attempts_ = 5;
+std::size_t FileCleanupQueue::completed_ = 0;
+
+void FileCleanupQueue::Start_()
+{
+    // Settings
+    journal_ = NAF::Tools::SettingsManager::GetSetting_("file_cleanup_journal", "structbx_file_cleanup.journal");
+    try
+    {
+        interval_ = std::stoi(NAF::Tools::SettingsManager::GetSetting_("file_cleanup_interval", "1000"));
+        batch_size_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("file_cleanup_batch", "100"));
+        max_attempts_ = std::stoi(NAF::Tools::SettingsManager::GetSetting_("file_cleanup_attempts", "5"));
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("FileCleanupQueue: file_cleanup_interval, file_cleanup_batch and file_cleanup_attempts must be integers");
+    }
+    if(batch_size_ < 1)
+        batch_size_ = 1;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(running_)
+        return;
+
+    // Resume the removals pending before the last stop or crash, with a compacted journal
+    ReadJournal_();
+    WriteJournal_();
+
+    running_ = true;
+    worker_ = std::thread(&FileCleanupQueue::Work_);
+}
+
+void FileCleanupQueue::Stop_()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(!running_)
+            return;
+        running_ = false;
+    }
+    condition_.notify_all();
+    if(worker_.joinable())
+        worker_.join();
+}
+
+bool FileCleanupQueue::Enqueue_(std::string path, bool directory)
+{
+    // Never remove outside the given path
+    if(path == "" || path == "/" || path.find("/../") != std::string::npos || path.substr(path.size() < 3 ? 0 : path.size() - 3) == "/..")
+    {
+        NAF::Tools::OutputLogger::Error_("FileCleanupQueue: Invalid path " + path);
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Append to the journal, the removal survives a restart
+    std::ofstream journal(journal_, std::ios::app);
+    if(!journal.is_open())
+    {
+        NAF::Tools::OutputLogger::Error_("FileCleanupQueue: Error opening journal " + journal_);
+        return false;
+    }
+    journal << (directory ? "D " : "F ") << path << "\n";
+    journal.flush();
+
+    // The worker wakes up on its interval, or earlier once a batch is full
+    entries_.push_back(Entry{path, directory, 0});
+    if(entries_.size() >= batch_size_)
+        condition_.notify_one();
+    return true;
+}
+
+void FileCleanupQueue::ReadJournal_()
+{
+    std::ifstream journal(journal_);
+    std::string line;
+    while(std::getline(journal, line))
+    {
+        if(line.size() < 3)
+            continue;
+
+        // "R path" closes the oldest pending entry of the path
+        if(line.front() == 'R')
+        {
+            auto path = line.substr(2);
+            auto found = std::find_if(entries_.begin(), entries_.end(), [&path](Entry& entry){ return entry.path == path; });
+            if(found != entries_.end())
+                entries_.erase(found);
+            continue;
+        }
+        entries_.push_back(Entry{line.substr(2), line.front() == 'D', 0});
+    }
+}
+
+void FileCleanupQueue::AppendJournal_(std::list<Entry>& done)
+{
+    if(done.empty())
+        return;
+
+    std::ofstream journal(journal_, std::ios::app);
+    if(!journal.is_open())
+    {
+        NAF::Tools::OutputLogger::Error_("FileCleanupQueue: Error opening journal " + journal_);
+        return;
+    }
+    for(auto& entry : done)
+        journal << "R " << entry.path << "\n";
+    journal.flush();
+    completed_ += done.size();
+
+    // Compact once finished entries outnumber the pending ones
+    if(completed_ >= batch_size_ * 10 && completed_ > entries_.size())
+    {
+        journal.close();
+        WriteJournal_();
+    }
+}
+
+void FileCleanupQueue::WriteJournal_()
+{
+    // Rewrite with the pending entries only, rename keeps the journal complete on a crash
+    auto tmp_journal = journal_ + ".tmp";
+    std::ofstream journal(tmp_journal, std::ios::trunc);
+    if(!journal.is_open())
+    {
+        NAF::Tools::OutputLogger::Error_("FileCleanupQueue: Error writing journal " + tmp_journal);
+        return;
+    }
+    for(auto& entry : entries_)
+        journal << (entry.directory ? "D " : "F ") << entry.path << "\n";
+    journal.close();
+    completed_ = 0;
+
+    try
+    {
+        Poco::File(tmp_journal).renameTo(journal_);
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Error_("FileCleanupQueue: " + std::string(e.what()));
+    }
+}
+
+bool FileCleanupQueue::Remove_(Entry& entry)
+{
+    try
+    {
+        Poco::File file(entry.path);
+        if(file.exists())
+            file.remove(entry.directory);
+        return true;
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Debug_("FileCleanupQueue: " + std::string(e.what()));
+        return false;
+    }
+}
+
+void FileCleanupQueue::Work_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(running_)
+    {
+        condition_.wait_for(lock, std::chrono::milliseconds(interval_));
+        if(entries_.empty())
+            continue;
+
+        // Take a batch
+        std::list<Entry> batch;
+        auto end = entries_.begin();
+        for(std::size_t i = 0; i < batch_size_ && end != entries_.end(); i++)
+            end++;
+        batch.splice(batch.begin(), entries_, entries_.begin(), end);
+
+        // Remove without holding the lock
+        lock.unlock();
+        std::list<Entry> failed;
+        std::list<Entry> done;
+        for(auto& entry : batch)
+        {
+            if(Remove_(entry))
+            {
+                done.push_back(entry);
+                continue;
+            }
+
+            entry.attempts++;
+            if(entry.attempts < max_attempts_)
+                failed.push_back(entry);
+            else
+            {
+                NAF::Tools::OutputLogger::Error_("FileCleanupQueue: Could not remove " + entry.path);
+                done.push_back(entry);
+            }
+        }
+        lock.lock();
+
+        // Failed entries are retried after the others, finished ones are appended to the journal
+        entries_.splice(entries_.end(), failed);
+        AppendJournal_(done);
+    }
+}
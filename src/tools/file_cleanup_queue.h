@@ -0,0 +1,66 @@
+
+#ifndef STRUCTBX_TOOLS_FILECLEANUPQUEUE
+#define STRUCTBX_TOOLS_FILECLEANUPQUEUE
+
+#include <list>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <condition_variable>
+
+#include "Poco/File.h"
+
+#include "core/nebula_atom.h"
+#include <tools/output_logger.h>
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class FileCleanupQueue;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::FileCleanupQueue
+{
+    public:
+        static void Start_();
+        static void Stop_();
+
+        // Files and directories are written to the journal before returning,
+        // the worker removes them later
+        static bool Enqueue_(std::string path, bool directory = false);
+
+    private:
+        struct Entry
+        {
+            std::string path;
+            bool directory;
+            int attempts;
+        };
+
+        static void ReadJournal_();
+        static void WriteJournal_();
+        static void AppendJournal_(std::list<Entry>& done);
+        static bool Remove_(Entry& entry);
+        static void Work_();
+
+        static std::mutex mutex_;
+        static std::list<Entry> entries_;
+        static std::condition_variable condition_;
+        static std::thread worker_;
+        static bool running_;
+        static std::string journal_;
+        static int interval_;
+        static std::size_t batch_size_;
+        static int max_attempts_;
+        static std::size_t completed_;
+};
+
+#endif //STRUCTBX_TOOLS_FILECLEANUPQUEUE
@@ -0,0 +1,82 @@
+
+#include "tools/file_sender.h"
+
+using namespace StructBX::Tools;
+
+bool FileSender::Send_(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response, std::string path, std::string content_type)
+{
+    static long long min_bytes = [](){
+        try
+        {
+            return std::stoll(NAF::Tools::SettingsManager::GetSetting_("sendfile_min_kb", "64")) * 1024;
+        }
+        catch(std::exception&)
+        {
+            NAF::Tools::OutputLogger::Error_("FileSender: sendfile_min_kb must be an integer");
+            return 64LL * 1024;
+        }
+    }();
+    if(min_bytes < 0 || content_type == "" || path.find("..") != std::string::npos)
+        return false;
+
+    // Only plain sockets, TLS needs the bytes in user space to encrypt them
+    auto request_impl = dynamic_cast<Poco::Net::HTTPServerRequestImpl*>(&request);
+    if(request_impl == nullptr)
+        return false;
+    auto& socket = request_impl->socket();
+    if(socket.secure())
+        return false;
+
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(file < 0)
+        return false;
+    struct stat status;
+    if(fstat(file, &status) != 0 || !S_ISREG(status.st_mode) || status.st_size < min_bytes)
+    {
+        close(file);
+        return false;
+    }
+
+    // Headers through Poco, the body straight to the socket
+    response.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
+    response.setContentType(content_type);
+    response.setContentLength64(status.st_size);
+    std::ostream& out = response.send();
+    out.flush();
+
+    off_t offset = 0;
+    int socket_fd = socket.impl()->sockfd();
+    while(offset < status.st_size)
+    {
+        auto sent = sendfile(socket_fd, file, &offset, status.st_size - offset);
+        if(sent > 0)
+            continue;
+        if(sent < 0 && errno == EINTR)
+            continue;
+        if(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && Wait_(socket_fd, socket.getSendTimeout()))
+            continue;
+        break;
+    }
+    close(file);
+
+    // The headers are out, a short body can only end the connection
+    if(offset < status.st_size)
+    {
+        NAF::Tools::OutputLogger::Debug_("FileSender: Download of " + path + " interrupted");
+        response.setKeepAlive(false);
+        try
+        {
+            socket.shutdownSend();
+        }
+        catch(std::exception&){}
+    }
+
+    return true;
+}
+
+bool FileSender::Wait_(int socket, Poco::Timespan timeout)
+{
+    struct pollfd pfd = {socket, POLLOUT, 0};
+    auto milliseconds = timeout.totalMilliseconds() > 0 ? static_cast<int>(timeout.totalMilliseconds()) : -1;
+    return poll(&pfd, 1, milliseconds) > 0;
+}
@@ -0,0 +1,45 @@
+
+#ifndef STRUCTBX_TOOLS_FILESENDER
+#define STRUCTBX_TOOLS_FILESENDER
+
+#include <string>
+
+#include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+
+#include "Poco/Net/StreamSocket.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerRequestImpl.h"
+#include "Poco/Net/HTTPServerResponse.h"
+
+#include "core/nebula_atom.h"
+#include <tools/output_logger.h>
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class FileSender;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::FileSender
+{
+    public:
+        // Sends the file with sendfile(2), the kernel copies it from the page cache to the socket.
+        // False if nothing was sent: TLS connections, small files or a file that can't be opened,
+        // the caller then uses its buffered path
+        static bool Send_(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response, std::string path, std::string content_type);
+
+    private:
+        static bool Wait_(int socket, Poco::Timespan timeout);
+};
+
+#endif //STRUCTBX_TOOLS_FILESENDER
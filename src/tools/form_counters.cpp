@@ -0,0 +1,357 @@
+
+#include "tools/form_counters.h"
+
+using namespace StructBX::Tools;
+
+std::mutex FormCounters::mutex_;
+std::mutex FormCounters::flush_mutex_;
+std::map<std::string, std::shared_ptr<FormCounters::Counter>> FormCounters::counters_;
+std::condition_variable FormCounters::condition_;
+std::thread FormCounters::worker_;
+std::thread FormCounters::reconciler_;
+bool FormCounters::running_ = false;
+int FormCounters::flush_interval_ = 1000;
+std::size_t FormCounters::batch_size_ = 100;
+int FormCounters::reconcile_interval_ = 3600;
+bool FormCounters::estimated_total_rows_ = false;
+
+void FormCounters::Start_()
+{
+    // Settings
+    try
+    {
+        flush_interval_ = std::stoi(NAF::Tools::SettingsManager::GetSetting_("change_int_flush_interval", "1000"));
+        batch_size_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("change_int_flush_batch", "100"));
+        reconcile_interval_ = std::stoi(NAF::Tools::SettingsManager::GetSetting_("total_rows_reconcile_interval", "3600"));
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("FormCounters: change_int_flush_interval, change_int_flush_batch and total_rows_reconcile_interval must be integers");
+    }
+    estimated_total_rows_ = NAF::Tools::SettingsManager::GetSetting_("forms_total_rows", "counter") == "estimate";
+    if(batch_size_ < 1)
+        batch_size_ = 1;
+
+    // Increments that were not flushed before a crash are lost, so every form
+    // is marked as changed once per start
+    BumpOnStart_();
+    SetupTotalRows_();
+
+    // Start flush and reconcile workers
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(running_)
+        return;
+    running_ = true;
+    worker_ = std::thread(&FormCounters::Work_);
+    if(!estimated_total_rows_)
+        reconciler_ = std::thread(&FormCounters::ReconcileWork_);
+}
+
+void FormCounters::Stop_()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(!running_)
+            return;
+        running_ = false;
+    }
+    condition_.notify_all();
+    if(worker_.joinable())
+        worker_.join();
+    if(reconciler_.joinable())
+        reconciler_.join();
+
+    // Flush the remaining increments
+    Flush_();
+}
+
+void FormCounters::Flush_()
+{
+    std::unique_lock<std::mutex> flush_lock(flush_mutex_);
+
+    // Take pending increments
+    std::vector<Pending> pending;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for(auto& it : counters_)
+        {
+            std::unique_lock<std::mutex> counter_lock(it.second->mutex);
+            if(it.second->pending_change_int == 0 && it.second->pending_total_rows == 0)
+                continue;
+            pending.push_back(Pending{it.second, it.second->pending_change_int, it.second->pending_total_rows});
+            it.second->pending_change_int = 0;
+            it.second->pending_total_rows = 0;
+        }
+    }
+
+    // Write increments in batches
+    for(std::size_t begin = 0; begin < pending.size(); begin += batch_size_)
+    {
+        auto end = std::min(pending.size(), begin + batch_size_);
+
+        std::string change_int_cases = "";
+        std::string total_rows_cases = "";
+        std::string conditions = "";
+        auto action = NAF::Functions::Action("a1");
+        for(std::size_t i = begin; i < end; i++)
+        {
+            auto& counter = pending[i].counter;
+            change_int_cases += "WHEN identifier = ? AND id_space = ? THEN ? ";
+            action.AddParameter_("form-identifier", counter->form_identifier, false);
+            action.AddParameter_("id_space", counter->space_id, false);
+            action.AddParameter_("increment", pending[i].change_int, false);
+        }
+        for(std::size_t i = begin; i < end; i++)
+        {
+            auto& counter = pending[i].counter;
+            total_rows_cases += "WHEN identifier = ? AND id_space = ? THEN ? ";
+            action.AddParameter_("form-identifier", counter->form_identifier, false);
+            action.AddParameter_("id_space", counter->space_id, false);
+            action.AddParameter_("rows", pending[i].total_rows, false);
+        }
+        for(std::size_t i = begin; i < end; i++)
+        {
+            auto& counter = pending[i].counter;
+            if(conditions == "")
+                conditions = "(identifier = ? AND id_space = ?)";
+            else
+                conditions += " OR (identifier = ? AND id_space = ?)";
+            action.AddParameter_("form-identifier", counter->form_identifier, false);
+            action.AddParameter_("id_space", counter->space_id, false);
+        }
+
+        action.set_sql_code(
+            "UPDATE forms "
+            "SET change_int = change_int + CASE " + change_int_cases + "ELSE 0 END "
+            ",total_rows = total_rows + CASE " + total_rows_cases + "ELSE 0 END "
+            "WHERE " + conditions
+        );
+
+        // On error, give the increments back to be retried on the next flush
+        if(!RoutedAction::Prepared_(action))
+        {
+            NAF::Tools::OutputLogger::Error_("FormCounters: Error flushing change_int, retrying on next flush");
+            for(std::size_t i = begin; i < end; i++)
+            {
+                std::unique_lock<std::mutex> counter_lock(pending[i].counter->mutex);
+                pending[i].counter->pending_change_int += pending[i].change_int;
+                pending[i].counter->pending_total_rows += pending[i].total_rows;
+            }
+            continue;
+        }
+        for(std::size_t i = begin; i < end; i++)
+        {
+            std::unique_lock<std::mutex> counter_lock(pending[i].counter->mutex);
+            pending[i].counter->flushed_total_rows += pending[i].total_rows;
+        }
+    }
+}
+
+void FormCounters::IncrementChangeInt_(std::string form_identifier, std::string space_id)
+{
+    auto counter = GetCounter_(form_identifier, space_id);
+
+    std::unique_lock<std::mutex> counter_lock(counter->mutex);
+    counter->pending_change_int++;
+    if(counter->loaded)
+        counter->change_int++;
+}
+
+bool FormCounters::ReadChangeInt_(std::string form_identifier, std::string space_id, int& change_int)
+{
+    auto counter = GetCounter_(form_identifier, space_id);
+    if(counter->loaded)
+    {
+        change_int = counter->change_int;
+        return true;
+    }
+
+    // First read: the stored value already contains every flushed increment,
+    // only pending ones must be added. It is read under the flush lock so no
+    // flush moves pending increments into it in between
+    std::unique_lock<std::mutex> flush_lock(flush_mutex_);
+    if(!counter->loaded)
+    {
+        auto action = NAF::Functions::Action("a1");
+        action.set_sql_code("SELECT change_int FROM forms WHERE identifier = ? AND id_space = ?");
+        action.AddParameter_("form-identifier", form_identifier, false);
+        action.AddParameter_("id_space", space_id, false);
+        if(!RoutedAction::Prepared_(action))
+        {
+            NAF::Tools::OutputLogger::Error_("FormCounters: Error reading change_int of form " + form_identifier);
+            return false;
+        }
+        auto stored_change_int = action.get_results()->First_();
+        if(stored_change_int->IsNull_())
+            return false;
+
+        std::unique_lock<std::mutex> counter_lock(counter->mutex);
+        counter->change_int = stored_change_int->Int_() + counter->pending_change_int;
+        counter->loaded = true;
+    }
+
+    change_int = counter->change_int;
+    return true;
+}
+
+void FormCounters::AddTotalRows_(std::string form_identifier, std::string space_id, int rows)
+{
+    if(rows == 0)
+        return;
+
+    auto counter = GetCounter_(form_identifier, space_id);
+
+    std::unique_lock<std::mutex> counter_lock(counter->mutex);
+    counter->pending_total_rows += rows;
+}
+
+int FormCounters::PendingTotalRows_(std::string form_identifier, std::string space_id)
+{
+    auto counter = GetCounter_(form_identifier, space_id);
+
+    std::unique_lock<std::mutex> counter_lock(counter->mutex);
+    return counter->pending_total_rows;
+}
+
+void FormCounters::Snapshot_(std::string form_identifier, std::string space_id, int& pending, long long& flushed)
+{
+    auto counter = GetCounter_(form_identifier, space_id);
+
+    std::unique_lock<std::mutex> counter_lock(counter->mutex);
+    pending = counter->pending_total_rows;
+    flushed = counter->flushed_total_rows;
+}
+
+bool FormCounters::UseEstimatedTotalRows_()
+{
+    return estimated_total_rows_;
+}
+
+std::shared_ptr<FormCounters::Counter> FormCounters::GetCounter_(std::string form_identifier, std::string space_id)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    auto key = space_id + "/" + form_identifier;
+    auto found = counters_.find(key);
+    if(found != counters_.end())
+        return found->second;
+
+    auto counter = std::make_shared<Counter>(form_identifier, space_id);
+    counters_.insert(std::make_pair(key, counter));
+    return counter;
+}
+
+void FormCounters::BumpOnStart_()
+{
+    auto action = NAF::Functions::Action("a1");
+    action.set_sql_code("UPDATE forms SET change_int = change_int + 1");
+    if(!RoutedAction::Prepared_(action))
+        NAF::Tools::OutputLogger::Error_("FormCounters: Error bumping change_int on start");
+}
+
+void FormCounters::SetupTotalRows_()
+{
+    // MySQL has no ADD COLUMN IF NOT EXISTS
+    auto action1 = NAF::Functions::Action("a1");
+    action1.set_sql_code(
+        "SELECT COUNT(1) AS total " \
+        "FROM information_schema.COLUMNS " \
+        "WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = 'forms' AND COLUMN_NAME = 'total_rows'"
+    );
+    if(!RoutedAction::Prepared_(action1))
+    {
+        NAF::Tools::OutputLogger::Error_("FormCounters: Error looking for total_rows column in forms");
+        return;
+    }
+    auto total = action1.get_results()->First_();
+    if(!total->IsNull_() && total->Int_() > 0)
+        return;
+
+    auto action2 = NAF::Functions::Action("a2");
+    action2.set_sql_code("ALTER TABLE forms ADD COLUMN total_rows BIGINT NOT NULL DEFAULT 0");
+    if(!RoutedAction::Prepared_(action2))
+        NAF::Tools::OutputLogger::Error_("FormCounters: Error adding total_rows column to forms");
+}
+
+void FormCounters::Reconcile_()
+{
+    auto action1 = NAF::Functions::Action("a1");
+    action1.set_sql_code("SELECT id, identifier, id_space FROM forms");
+    if(!RoutedAction::Prepared_(action1))
+    {
+        NAF::Tools::OutputLogger::Error_("FormCounters: Error reading forms to reconcile total_rows");
+        return;
+    }
+
+    for(auto row : *action1.get_results())
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if(!running_)
+                return;
+        }
+
+        auto id = row->ExtractField_("id");
+        auto identifier = row->ExtractField_("identifier");
+        auto id_space = row->ExtractField_("id_space");
+        if(id->IsNull_() || identifier->IsNull_() || id_space->IsNull_())
+            continue;
+
+        // Count without the flush lock, it takes long on big tables. Rows pending before
+        // the count are not stored yet, rows flushed while it ran are stored since
+        int pending_before;
+        long long flushed_before;
+        Snapshot_(identifier->ToString_(), id_space->ToString_(), pending_before, flushed_before);
+
+        auto action2 = NAF::Functions::Action("a2");
+        action2.set_sql_code(
+            "SELECT COUNT(1) AS total " \
+            "FROM _structbx_space_" + id_space->ToString_() + "._structbx_form_" + id->ToString_());
+        if(!ShardMap::Prepared_(action2, id_space->ToString_()))
+            continue;
+        auto total = action2.get_results()->First_();
+        if(total->IsNull_())
+            continue;
+
+        // Stored under the flush lock, no flush can land between the snapshot and the update
+        std::unique_lock<std::mutex> flush_lock(flush_mutex_);
+        int pending_after;
+        long long flushed_after;
+        Snapshot_(identifier->ToString_(), id_space->ToString_(), pending_after, flushed_after);
+
+        auto action3 = NAF::Functions::Action("a3");
+        action3.set_sql_code("UPDATE forms SET total_rows = ? WHERE id = ?");
+        action3.AddParameter_("total_rows", static_cast<int>(total->Int_() - pending_before + (flushed_after - flushed_before)), false);
+        action3.AddParameter_("id", id->Int_(), false);
+        if(!RoutedAction::Prepared_(action3))
+            NAF::Tools::OutputLogger::Error_("FormCounters: Error reconciling total_rows of form " + id->ToString_());
+    }
+}
+
+void FormCounters::Work_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(running_)
+    {
+        condition_.wait_for(lock, std::chrono::milliseconds(flush_interval_));
+        if(!running_)
+            break;
+
+        lock.unlock();
+        Flush_();
+        lock.lock();
+    }
+}
+
+void FormCounters::ReconcileWork_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(running_)
+    {
+        lock.unlock();
+        Reconcile_();
+        lock.lock();
+
+        condition_.wait_for(lock, std::chrono::seconds(reconcile_interval_), []{ return !running_; });
+    }
+}
@@ -0,0 +1,97 @@
+
+#ifndef STRUCTBX_TOOLS_FORMCOUNTERS
+#define STRUCTBX_TOOLS_FORMCOUNTERS
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
+
+#include "core/nebula_atom.h"
+#include "functions/action.h"
+#include <tools/output_logger.h>
+
+#include "tools/shard_map.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class FormCounters;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::FormCounters
+{
+    public:
+        static void Start_();
+        static void Stop_();
+        static void Flush_();
+
+        static void IncrementChangeInt_(std::string form_identifier, std::string space_id);
+        static bool ReadChangeInt_(std::string form_identifier, std::string space_id, int& change_int);
+
+        static void AddTotalRows_(std::string form_identifier, std::string space_id, int rows);
+        static int PendingTotalRows_(std::string form_identifier, std::string space_id);
+        static bool UseEstimatedTotalRows_();
+
+    private:
+        struct Counter
+        {
+            Counter(std::string form_identifier, std::string space_id) :
+                form_identifier(form_identifier)
+                ,space_id(space_id)
+                ,loaded(false)
+                ,change_int(0)
+                ,pending_change_int(0)
+                ,pending_total_rows(0)
+                ,flushed_total_rows(0)
+            {}
+
+            std::string form_identifier;
+            std::string space_id;
+            std::mutex mutex;
+            std::atomic<bool> loaded;
+            std::atomic<int> change_int;
+            int pending_change_int;
+            int pending_total_rows;
+            long long flushed_total_rows;
+        };
+        struct Pending
+        {
+            std::shared_ptr<Counter> counter;
+            int change_int;
+            int total_rows;
+        };
+
+        static std::shared_ptr<Counter> GetCounter_(std::string form_identifier, std::string space_id);
+        static void BumpOnStart_();
+        static void SetupTotalRows_();
+        static void Snapshot_(std::string form_identifier, std::string space_id, int& pending, long long& flushed);
+        static void Reconcile_();
+        static void Work_();
+        static void ReconcileWork_();
+
+        static std::mutex mutex_;
+        static std::mutex flush_mutex_;
+        static std::map<std::string, std::shared_ptr<Counter>> counters_;
+        static std::condition_variable condition_;
+        static std::thread worker_;
+        static std::thread reconciler_;
+        static bool running_;
+        static int flush_interval_;
+        static std::size_t batch_size_;
+        static int reconcile_interval_;
+        static bool estimated_total_rows_;
+};
+
+#endif //STRUCTBX_TOOLS_FORMCOUNTERS
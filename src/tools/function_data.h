@@ -33,12 +33,14 @@ class StructBX::Tools::FunctionData
         FunctionData() :
             id_user_(-1)
             ,space_id_("")
+            ,organization_id_("")
         {
             functions_ = std::make_shared<std::list<NAF::Functions::Function::Ptr>>();
         }
         FunctionData(FunctionData& function_data) :
             id_user_(function_data.get_id_user())
             ,space_id_(function_data.get_space_id())
+            ,organization_id_(function_data.get_organization_id())
             ,functions_(function_data.get_functions())
         {
             
@@ -46,6 +48,7 @@ class StructBX::Tools::FunctionData
 
         int get_id_user(){ return id_user_; }
         std::string get_space_id(){ return space_id_; }
+        std::string get_organization_id(){ return organization_id_; }
         FunctionsList& get_functions()
         {
             auto& var = functions_;
@@ -54,11 +57,13 @@ class StructBX::Tools::FunctionData
 
         void set_id_user(int id_user){ id_user_ = id_user; }
         void set_space_id(std::string space_id){ space_id_ = space_id; }
+        void set_organization_id(std::string organization_id){ organization_id_ = organization_id; }
         void set_functions(FunctionsList functions){ functions_ = functions; }
 
     private:
         int id_user_;
         std::string space_id_;
+        std::string organization_id_;
         FunctionsList functions_;
 };
 
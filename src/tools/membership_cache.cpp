@@ -0,0 +1,106 @@
+
+#include "tools/membership_cache.h"
+
+using namespace StructBX::Tools;
+
+std::mutex MembershipCache::mutex_;
+std::map<int, MembershipCache::Entry> MembershipCache::entries_;
+unsigned long MembershipCache::generation_ = 0;
+
+MembershipCache::Membership MembershipCache::Get_(int id_user)
+{
+    unsigned long generation;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto found = entries_.find(id_user);
+        if(found != entries_.end() && std::chrono::steady_clock::now() - found->second.loaded < std::chrono::seconds(TTL_()))
+            return found->second.membership;
+        generation = generation_;
+    }
+
+    Membership membership;
+    if(!Load_(id_user, membership))
+        return membership;
+
+    // Don't store what was read before an invalidation
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(generation == generation_)
+        entries_[id_user] = Entry{membership, std::chrono::steady_clock::now()};
+
+    return membership;
+}
+
+bool MembershipCache::IsMember_(int id_user, std::string space_id)
+{
+    auto membership = Get_(id_user);
+    return membership.spaces.find(space_id) != membership.spaces.end();
+}
+
+void MembershipCache::Invalidate_(int id_user)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    entries_.erase(id_user);
+    generation_++;
+}
+
+void MembershipCache::InvalidateAll_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    entries_.clear();
+    generation_++;
+}
+
+bool MembershipCache::Load_(int id_user, Membership& membership)
+{
+    auto action = NAF::Functions::Action("a1");
+    action.set_sql_code(
+        "SELECT nu.id_group, ou.id_organization, s.id AS id_space " \
+        "FROM _naf_users nu " \
+        "LEFT JOIN organizations_users ou ON ou.id_naf_user = nu.id " \
+        "LEFT JOIN spaces_users su ON su.id_naf_user = nu.id " \
+        "LEFT JOIN spaces s ON s.id = su.id_space " \
+        "WHERE nu.id = ?"
+    );
+    action.AddParameter_("id_naf_user", id_user, false);
+    if(!RoutedAction::Prepared_(action))
+    {
+        NAF::Tools::OutputLogger::Error_("MembershipCache: Error reading membership of user " + std::to_string(id_user));
+        return false;
+    }
+
+    for(auto row : *action.get_results())
+    {
+        auto id_group = row->ExtractField_("id_group");
+        auto id_organization = row->ExtractField_("id_organization");
+        auto id_space = row->ExtractField_("id_space");
+        if(!id_group->IsNull_())
+            membership.group_id = id_group->ToString_();
+        if(!id_organization->IsNull_())
+            membership.organization_id = id_organization->ToString_();
+        if(id_space->IsNull_())
+            continue;
+
+        if(membership.first_space == "")
+            membership.first_space = id_space->ToString_();
+        membership.spaces.insert(id_space->ToString_());
+    }
+
+    return true;
+}
+
+int MembershipCache::TTL_()
+{
+    static int ttl = [](){
+        try
+        {
+            return std::stoi(NAF::Tools::SettingsManager::GetSetting_("membership_cache_ttl", "300"));
+        }
+        catch(std::exception&)
+        {
+            NAF::Tools::OutputLogger::Error_("MembershipCache: membership_cache_ttl must be an integer");
+            return 300;
+        }
+    }();
+
+    return ttl;
+}
@@ -0,0 +1,62 @@
+
+#ifndef STRUCTBX_TOOLS_MEMBERSHIPCACHE
+#define STRUCTBX_TOOLS_MEMBERSHIPCACHE
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <string>
+#include <chrono>
+
+#include "core/nebula_atom.h"
+#include "functions/action.h"
+#include <tools/output_logger.h>
+
+#include "tools/routed_action.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class MembershipCache;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::MembershipCache
+{
+    public:
+        struct Membership
+        {
+            std::string organization_id = "";
+            std::string group_id = "";
+            std::string first_space = "";
+            std::set<std::string> spaces;
+        };
+
+        // Loaded from the database on the first request of a user
+        static Membership Get_(int id_user);
+        static bool IsMember_(int id_user, std::string space_id);
+
+        // Called after spaces_users, organizations_users or _naf_users change
+        static void Invalidate_(int id_user);
+        static void InvalidateAll_();
+
+    private:
+        struct Entry
+        {
+            Membership membership;
+            std::chrono::steady_clock::time_point loaded;
+        };
+
+        static bool Load_(int id_user, Membership& membership);
+        static int TTL_();
+
+        static std::mutex mutex_;
+        static std::map<int, Entry> entries_;
+        static unsigned long generation_;
+};
+
+#endif //STRUCTBX_TOOLS_MEMBERSHIPCACHE
@@ -0,0 +1,133 @@
+
+#include "tools/permissions_table.h"
+
+using namespace StructBX::Tools;
+
+std::shared_ptr<PermissionsTable::Table> PermissionsTable::table_;
+std::shared_mutex PermissionsTable::reload_mutex_;
+
+namespace
+{
+    const std::size_t kMethods = 4;
+
+    int MethodIndex_(const std::string& method)
+    {
+        if(method == "GET") return 0;
+        if(method == "POST") return 1;
+        if(method == "PUT") return 2;
+        if(method == "DELETE") return 3;
+        return -1;
+    }
+}
+
+void PermissionsTable::Compile_(std::list<NAF::Functions::Function::Ptr>& functions)
+{
+    if(std::atomic_load(&table_))
+        return;
+
+    std::unordered_map<std::string, std::size_t> endpoints;
+    for(auto& function : functions)
+        endpoints.emplace(function->get_endpoint(), endpoints.size());
+
+    // Another request may have compiled it meanwhile
+    auto table = Build_(endpoints);
+    std::shared_ptr<Table> empty;
+    std::atomic_compare_exchange_strong(&table_, &empty, table);
+}
+
+bool PermissionsTable::Verify_(int id_group, const std::string& endpoint, const std::string& method, std::function<bool()> verify)
+{
+    std::size_t index;
+    auto table = std::atomic_load(&table_);
+    if(table && Index_(*table, id_group, endpoint, method, index))
+    {
+        auto state = Check_(*table, index);
+        if(state != State::kUnknown)
+            return state == State::kAllowed;
+    }
+
+    // First time for this group, endpoint and method. The table is taken again
+    // under the lock so the result is recorded with the rules it was verified with
+    std::shared_lock<std::shared_mutex> lock(reload_mutex_);
+    table = std::atomic_load(&table_);
+    bool allowed = verify();
+    if(table && Index_(*table, id_group, endpoint, method, index))
+        Record_(*table, index, allowed);
+
+    return allowed;
+}
+
+void PermissionsTable::Reload_()
+{
+    std::unique_lock<std::shared_mutex> lock(reload_mutex_);
+    NAF::Security::PermissionsManager::LoadPermissions_();
+
+    auto current = std::atomic_load(&table_);
+    if(!current)
+        return;
+
+    std::atomic_store(&table_, Build_(current->endpoints));
+}
+
+PermissionsTable::State PermissionsTable::Check_(Table& table, std::size_t index)
+{
+    auto bit = std::uint64_t(1) << (index % 64);
+    if(!(table.known[index / 64].load(std::memory_order_acquire) & bit))
+        return State::kUnknown;
+
+    return table.allowed[index / 64].load(std::memory_order_relaxed) & bit ? State::kAllowed : State::kDenied;
+}
+
+void PermissionsTable::Record_(Table& table, std::size_t index, bool allowed)
+{
+    // The allowed bit is published before the known bit
+    auto bit = std::uint64_t(1) << (index % 64);
+    if(allowed)
+        table.allowed[index / 64].fetch_or(bit, std::memory_order_relaxed);
+    table.known[index / 64].fetch_or(bit, std::memory_order_release);
+}
+
+std::shared_ptr<PermissionsTable::Table> PermissionsTable::Build_(std::unordered_map<std::string, std::size_t> endpoints)
+{
+    auto table = std::make_shared<Table>();
+    table->endpoints = std::move(endpoints);
+
+    // Groups
+    auto action = NAF::Functions::Action("a1");
+    action.set_sql_code("SELECT id FROM _naf_groups");
+    if(RoutedAction::Prepared_(action))
+    {
+        for(auto row : *action.get_results())
+        {
+            auto id = row->ExtractField_("id");
+            if(!id->IsNull_())
+                table->groups.emplace(id->Int_(), table->groups.size());
+        }
+    }
+    else
+        NAF::Tools::OutputLogger::Error_("PermissionsTable: Error reading groups");
+
+    // Dense group x endpoint x method bitsets
+    auto words = (table->groups.size() * table->endpoints.size() * kMethods + 63) / 64;
+    table->known.reset(new std::atomic<std::uint64_t>[words]);
+    table->allowed.reset(new std::atomic<std::uint64_t>[words]);
+    for(std::size_t i = 0; i < words; ++i)
+    {
+        table->known[i].store(0);
+        table->allowed[i].store(0);
+    }
+
+    return table;
+}
+
+bool PermissionsTable::Index_(Table& table, int id_group, const std::string& endpoint, const std::string& method, std::size_t& index)
+{
+    auto group = table.groups.find(id_group);
+    auto found = table.endpoints.find(endpoint);
+    auto method_index = MethodIndex_(method);
+    if(group == table.groups.end() || found == table.endpoints.end() || method_index < 0)
+        return false;
+
+    index = (group->second * table.endpoints.size() + found->second) * kMethods + method_index;
+    return true;
+}
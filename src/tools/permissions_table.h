@@ -0,0 +1,72 @@
+
+#ifndef STRUCTBX_TOOLS_PERMISSIONSTABLE
+#define STRUCTBX_TOOLS_PERMISSIONSTABLE
+
+#include <list>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "core/nebula_atom.h"
+#include "functions/function.h"
+#include "functions/action.h"
+#include <tools/output_logger.h>
+
+#include "tools/routed_action.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class PermissionsTable;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::PermissionsTable
+{
+    public:
+        enum class State
+        {
+            kUnknown
+            ,kDenied
+            ,kAllowed
+        };
+
+        // Endpoint registry, built once from the functions of the backend
+        static void Compile_(std::list<NAF::Functions::Function::Ptr>& functions);
+
+        // One bit test once the result of a group, endpoint and method is known,
+        // before that verify runs and its result is recorded in the same table
+        static bool Verify_(int id_group, const std::string& endpoint, const std::string& method, std::function<bool()> verify);
+
+        // Reloads the NAF permissions and swaps in an empty table with the current
+        // groups, verifications wait until both are done
+        static void Reload_();
+
+    private:
+        struct Table
+        {
+            std::unordered_map<std::string, std::size_t> endpoints;
+            std::unordered_map<int, std::size_t> groups;
+            std::unique_ptr<std::atomic<std::uint64_t>[]> known;
+            std::unique_ptr<std::atomic<std::uint64_t>[]> allowed;
+        };
+
+        static std::shared_ptr<Table> Build_(std::unordered_map<std::string, std::size_t> endpoints);
+        static bool Index_(Table& table, int id_group, const std::string& endpoint, const std::string& method, std::size_t& index);
+        static State Check_(Table& table, std::size_t index);
+        static void Record_(Table& table, std::size_t index, bool allowed);
+
+        static std::shared_ptr<Table> table_;
+        static std::shared_mutex reload_mutex_;
+};
+
+#endif //STRUCTBX_TOOLS_PERMISSIONSTABLE
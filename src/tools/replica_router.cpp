@@ -0,0 +1,63 @@
+
+#include "tools/replica_router.h"
+
+using namespace StructBX::Tools;
+
+std::mutex ReplicaRouter::mutex_;
+std::map<int, std::chrono::steady_clock::time_point> ReplicaRouter::writes_;
+
+void ReplicaRouter::MarkWrite_(int id_user)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    writes_[id_user] = std::chrono::steady_clock::now();
+
+    // Forget users whose window is over
+    if(writes_.size() > 1024)
+    {
+        auto now = std::chrono::steady_clock::now();
+        for(auto it = writes_.begin(); it != writes_.end();)
+        {
+            if(now - it->second > std::chrono::minutes(5))
+                it = writes_.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+bool ReplicaRouter::Read_(Functions::Action::Ptr action, int id_user, std::string space_id)
+{
+    auto shard = ShardMap::Locate_(space_id);
+    if(shard != "")
+        return RoutedAction::Work_(*action, shard);
+
+    // A replica that fails falls back to the primary
+    auto replica = Sticky_(id_user) ? "" : ConnectionPool::Replica_();
+    if(replica != "")
+    {
+        if(RoutedAction::Work_(*action, replica))
+            return true;
+        NAF::Tools::OutputLogger::Error_("ReplicaRouter: Read on " + replica + " failed, using the primary");
+    }
+
+    return RoutedAction::Prepared_(*action);
+}
+
+bool ReplicaRouter::Sticky_(int id_user)
+{
+    static int seconds = [](){
+        try
+        {
+            return std::stoi(NAF::Tools::SettingsManager::GetSetting_("db_replica_sticky_seconds", "5"));
+        }
+        catch(std::exception&)
+        {
+            NAF::Tools::OutputLogger::Error_("ReplicaRouter: db_replica_sticky_seconds must be an integer");
+            return 5;
+        }
+    }();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto found = writes_.find(id_user);
+    return found != writes_.end() && std::chrono::steady_clock::now() - found->second < std::chrono::seconds(seconds);
+}
@@ -0,0 +1,45 @@
+
+#ifndef STRUCTBX_TOOLS_REPLICAROUTER
+#define STRUCTBX_TOOLS_REPLICAROUTER
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <chrono>
+
+#include "core/nebula_atom.h"
+#include "functions/action.h"
+#include <tools/output_logger.h>
+
+#include "tools/connection_pool.h"
+#include "tools/routed_action.h"
+#include "tools/shard_map.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class ReplicaRouter;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::ReplicaRouter
+{
+    public:
+        // Users read from the primary for db_replica_sticky_seconds after they write
+        static void MarkWrite_(int id_user);
+
+        // Read-only queries on the data of a space, replicas only serve spaces on the primary
+        static bool Read_(Functions::Action::Ptr action, int id_user, std::string space_id);
+
+    private:
+        static bool Sticky_(int id_user);
+
+        static std::mutex mutex_;
+        static std::map<int, std::chrono::steady_clock::time_point> writes_;
+};
+
+#endif //STRUCTBX_TOOLS_REPLICAROUTER
@@ -0,0 +1,93 @@
+
+#include "tools/routed_action.h"
+
+using namespace StructBX::Tools;
+
+bool RoutedAction::Work_(Functions::Action& action, std::string endpoint)
+{
+    if(endpoint == "")
+        return action.Work_();
+
+    return Prepared_(action, endpoint);
+}
+
+bool RoutedAction::Prepared_(Functions::Action& action, std::string endpoint)
+{
+    // Verify and bind values, empty values are NULL
+    std::vector<Poco::Nullable<std::string>> values;
+    values.reserve(action.get_parameters().size());
+    for(auto& param : action.get_parameters())
+    {
+        if(!param->VerifyCondition_())
+        {
+            action.set_custom_error(param->get_error());
+            return false;
+        }
+
+        if(param->get_value()->TypeIsIqual_(NAF::Tools::DValue::Type::kEmpty))
+            values.push_back(Poco::Nullable<std::string>());
+        else
+            values.push_back(Poco::Nullable<std::string>(param->get_value()->ToString_()));
+    }
+
+    try
+    {
+        auto session = ConnectionPool::Get_(endpoint);
+        auto& statement = session.Statements_().Execute_(*session, action.get_sql_code(), values).statement;
+
+        Results_(action, statement);
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Error_("RoutedAction (" + action.get_identifier() + ", " + endpoint + "): " + std::string(e.what()));
+        action.set_custom_error("No se pudo completar la operaci&oacute;n");
+        return false;
+    }
+
+    // Action conditions verify the results, as Action::Work_ does
+    auto condition = action.get_condition();
+    if(condition && condition->get_type() == Query::ConditionType::kError && !condition->get_functor()(action))
+        return false;
+
+    return true;
+}
+
+void RoutedAction::Results_(Functions::Action& action, Poco::Data::Statement& statement)
+{
+    // Rows and JSON result, in the same shape that NAF leaves them
+    action.get_results()->clear();
+    if(statement.columnsExtracted() > 0)
+    {
+        Poco::Data::RecordSet records(statement);
+        for(std::size_t row_index = 0; row_index < records.rowCount(); ++row_index)
+        {
+            auto row = std::make_shared<NAF::Query::Row>();
+            for(std::size_t column = 0; column < records.columnCount(); ++column)
+            {
+                auto value = records.value(column, row_index);
+                row->AddField_(records.columnName(column), Value_(value));
+            }
+            action.get_results()->push_back(row);
+        }
+    }
+    action.CreateJSONResult_();
+}
+
+NAF::Tools::DValue::Ptr RoutedAction::Value_(Poco::Dynamic::Var& value)
+{
+    try
+    {
+        if(value.isEmpty())
+            return NAF::Tools::DValue::Ptr(new NAF::Tools::DValue());
+        if(value.isInteger() && value.convert<long long>() == value.convert<int>())
+            return NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(value.convert<int>()));
+        if(value.isNumeric() && !value.isInteger())
+            return NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(static_cast<float>(value.convert<double>())));
+
+        return NAF::Tools::DValue::Ptr(new NAF::Tools::DValue(value.convert<std::string>()));
+    }
+    catch(std::exception&)
+    {
+        return NAF::Tools::DValue::Ptr(new NAF::Tools::DValue());
+    }
+}
@@ -0,0 +1,50 @@
+
+#ifndef STRUCTBX_TOOLS_ROUTEDACTION
+#define STRUCTBX_TOOLS_ROUTEDACTION
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "Poco/Nullable.h"
+#include "Poco/Dynamic/Var.h"
+#include "Poco/Data/Session.h"
+#include "Poco/Data/Statement.h"
+#include "Poco/Data/RecordSet.h"
+
+#include "functions/action.h"
+#include <query/parameter.h>
+#include <tools/output_logger.h>
+
+#include "tools/connection_pool.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class RoutedAction;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::RoutedAction
+{
+    public:
+        // Endpoint "" runs the action through NAF, any other ConnectionPool endpoint
+        // runs it there and leaves the rows and the JSON result in the action
+        static bool Work_(Functions::Action& action, std::string endpoint);
+
+        // Runs the action on a pooled session of the endpoint with a prepared statement,
+        // verifying parameters and error conditions as NAF does
+        static bool Prepared_(Functions::Action& action, std::string endpoint = "");
+
+        // Leaves the rows of an executed statement and the JSON result in the action
+        static void Results_(Functions::Action& action, Poco::Data::Statement& statement);
+
+    private:
+        static NAF::Tools::DValue::Ptr Value_(Poco::Dynamic::Var& value);
+};
+
+#endif //STRUCTBX_TOOLS_ROUTEDACTION
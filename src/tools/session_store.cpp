@@ -0,0 +1,124 @@
+
+#include "tools/session_store.h"
+
+using namespace StructBX::Tools;
+
+std::array<SessionStore::Shard, 16> SessionStore::shards_;
+
+bool SessionStore::Find_(std::string key, Entry& entry)
+{
+    auto& shard = Shard_(key);
+    bool expired = false;
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto found = shard.entries.find(key);
+        if(found == shard.entries.end())
+            return false;
+
+        if(std::chrono::steady_clock::now() < found->second.expires)
+        {
+            entry = found->second;
+            return true;
+        }
+        expired = true;
+    }
+
+    // Expired entries are removed when they are found
+    if(expired)
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto found = shard.entries.find(key);
+        if(found != shard.entries.end() && std::chrono::steady_clock::now() >= found->second.expires)
+            shard.entries.erase(found);
+    }
+
+    return false;
+}
+
+void SessionStore::Insert_(std::string key, int id_user, int id_group)
+{
+    auto& shard = Shard_(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.entries[key] = Entry{id_user, id_group, std::chrono::steady_clock::now() + std::chrono::seconds(TTL_())};
+
+    // Sessions that are never used again are swept when the shard doubles
+    if(shard.entries.size() > 64 && shard.entries.size() >= shard.swept_size * 2)
+        Sweep_(shard);
+}
+
+void SessionStore::Erase_(std::string key)
+{
+    auto& shard = Shard_(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.entries.erase(key);
+}
+
+void SessionStore::EraseUser_(int id_user)
+{
+    for(auto& shard : shards_)
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        for(auto it = shard.entries.begin(); it != shard.entries.end();)
+        {
+            if(it->second.id_user == id_user)
+                it = shard.entries.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+void SessionStore::Clear_()
+{
+    for(auto& shard : shards_)
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.entries.clear();
+        shard.swept_size = 0;
+    }
+}
+
+std::string SessionStore::Key_(Poco::Net::NameValueCollection& cookies)
+{
+    static std::string session_cookie_name = NAF::Tools::SettingsManager::GetSetting_("session_cookie_name", "1f3efd18688d2");
+    auto found = cookies.find(session_cookie_name);
+    if(found == cookies.end())
+        return "";
+
+    return found->second;
+}
+
+SessionStore::Shard& SessionStore::Shard_(const std::string& key)
+{
+    return shards_[std::hash<std::string>()(key) % shards_.size()];
+}
+
+void SessionStore::Sweep_(Shard& shard)
+{
+    auto now = std::chrono::steady_clock::now();
+    for(auto it = shard.entries.begin(); it != shard.entries.end();)
+    {
+        if(now >= it->second.expires)
+            it = shard.entries.erase(it);
+        else
+            ++it;
+    }
+    shard.swept_size = shard.entries.size();
+}
+
+int SessionStore::TTL_()
+{
+    static int ttl = [](){
+        try
+        {
+            return std::stoi(NAF::Tools::SettingsManager::GetSetting_("session_cache_ttl", "0"));
+        }
+        catch(std::exception&)
+        {
+            NAF::Tools::OutputLogger::Error_("SessionStore: session_cache_ttl must be an integer");
+            return 0;
+        }
+    }();
+
+    return ttl;
+}
@@ -0,0 +1,66 @@
+
+#ifndef STRUCTBX_TOOLS_SESSIONSTORE
+#define STRUCTBX_TOOLS_SESSIONSTORE
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "Poco/Net/NameValueCollection.h"
+
+#include "core/nebula_atom.h"
+#include <tools/output_logger.h>
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class SessionStore;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::SessionStore
+{
+    public:
+        struct Entry
+        {
+            int id_user = -1;
+            int id_group = -1;
+            std::chrono::steady_clock::time_point expires;
+        };
+
+        // Sessions already verified by SessionsManager, kept for session_cache_ttl seconds,
+        // 0 (the default) turns the cache off
+        static bool Enabled_() { return TTL_() > 0; }
+        static bool Find_(std::string key, Entry& entry);
+        static void Insert_(std::string key, int id_user, int id_group);
+        static void Erase_(std::string key);
+        static void EraseUser_(int id_user);
+
+        // Session cookie of NAF from session_cookie_name, "" without it
+        static std::string Key_(Poco::Net::NameValueCollection& cookies);
+        static void Clear_();
+
+    private:
+        struct Shard
+        {
+            std::shared_mutex mutex;
+            std::unordered_map<std::string, Entry> entries;
+            std::size_t swept_size = 0;
+        };
+
+        static Shard& Shard_(const std::string& key);
+        static void Sweep_(Shard& shard);
+        static int TTL_();
+
+        static std::array<Shard, 16> shards_;
+};
+
+#endif //STRUCTBX_TOOLS_SESSIONSTORE
@@ -0,0 +1,157 @@
+
+#include "tools/session_token.h"
+
+using namespace StructBX::Tools;
+
+std::mutex SessionToken::mutex_;
+std::map<int, long long> SessionToken::revoked_;
+long long SessionToken::revoked_all_ = 0;
+
+bool SessionToken::Enabled_()
+{
+    static bool enabled = NAF::Tools::SettingsManager::GetSetting_("session_tokens", "false") == "true";
+    return enabled;
+}
+
+std::string SessionToken::CookieName_()
+{
+    return NAF::Tools::SettingsManager::GetSetting_("session_token_cookie_name", "5a7c01e94bd32");
+}
+
+std::string SessionToken::Issue_(Claims claims)
+{
+    claims.issued = Now_();
+    claims.expiry = claims.issued + Ttl_();
+
+    std::string payload =
+        std::to_string(claims.id_user) + ":" +
+        std::to_string(claims.id_group) + ":" +
+        claims.space_id + ":" +
+        claims.organization_id + ":" +
+        std::to_string(claims.issued) + ":" +
+        std::to_string(claims.expiry);
+
+    return payload + "." + Sign_(payload);
+}
+
+bool SessionToken::Verify_(std::string token, Claims& claims)
+{
+    auto dot = token.rfind('.');
+    if(dot == std::string::npos)
+        return false;
+
+    auto payload = token.substr(0, dot);
+    if(!Equal_(Sign_(payload), token.substr(dot + 1)))
+        return false;
+
+    // Fields
+    std::vector<std::string> fields;
+    std::stringstream stream(payload);
+    std::string field;
+    while(std::getline(stream, field, ':'))
+        fields.push_back(field);
+    if(fields.size() != 6)
+        return false;
+
+    try
+    {
+        claims.id_user = std::stoi(fields[0]);
+        claims.id_group = std::stoi(fields[1]);
+        claims.space_id = fields[2];
+        claims.organization_id = fields[3];
+        claims.issued = std::stoll(fields[4]);
+        claims.expiry = std::stoll(fields[5]);
+    }
+    catch(std::exception&)
+    {
+        return false;
+    }
+
+    if(Now_() >= claims.expiry || claims.expiry - claims.issued > Ttl_())
+        return false;
+
+    // Revocation list
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(claims.issued <= revoked_all_)
+        return false;
+
+    auto found = revoked_.find(claims.id_user);
+    if(found != revoked_.end())
+    {
+        if(claims.issued <= found->second)
+            return false;
+        if(found->second <= Now_() - 24 * 3600)
+            revoked_.erase(found);
+    }
+
+    return true;
+}
+
+void SessionToken::RevokeUser_(int id_user)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    revoked_[id_user] = Now_();
+}
+
+void SessionToken::RevokeAll_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    revoked_all_ = Now_();
+    revoked_.clear();
+}
+
+long long SessionToken::Ttl_()
+{
+    static long long ttl = []()
+    {
+        try
+        {
+            return std::stoll(NAF::Tools::SettingsManager::GetSetting_("session_token_ttl", "900"));
+        }
+        catch(std::exception&)
+        {
+            NAF::Tools::OutputLogger::Error_("SessionToken: session_token_ttl must be an integer");
+            return 900LL;
+        }
+    }();
+    return ttl;
+}
+
+std::string SessionToken::Sign_(const std::string& payload)
+{
+    // Own key and prefix, a password hash of _naf_users must never verify as a token
+    static std::string key = []()
+    {
+        auto secret = NAF::Tools::SettingsManager::GetSetting_("session_token_secret", "");
+        if(secret != "")
+            return secret;
+
+        // Without a configured secret tokens last until the next restart
+        std::string random(32, '\0');
+        Poco::RandomInputStream stream;
+        stream.read(&random[0], random.size());
+        return random;
+    }();
+
+    Poco::HMACEngine<Poco::SHA1Engine> hmac(key);
+    hmac.update("structbx-session-token\n" + payload);
+    return Poco::DigestEngine::digestToHex(hmac.digest());
+}
+
+long long SessionToken::Now_()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool SessionToken::Equal_(const std::string& a, const std::string& b)
+{
+    // Constant time, the signature must not leak through timing
+    if(a.size() != b.size())
+        return false;
+
+    unsigned char result = 0;
+    for(std::size_t i = 0; i < a.size(); ++i)
+        result |= a[i] ^ b[i];
+
+    return result == 0;
+}
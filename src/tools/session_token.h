@@ -0,0 +1,65 @@
+
+#ifndef STRUCTBX_TOOLS_SESSIONTOKEN
+#define STRUCTBX_TOOLS_SESSIONTOKEN
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <sstream>
+
+#include "Poco/HMACEngine.h"
+#include "Poco/SHA1Engine.h"
+#include "Poco/RandomStream.h"
+
+#include "core/nebula_atom.h"
+#include <tools/output_logger.h>
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class SessionToken;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::SessionToken
+{
+    public:
+        struct Claims
+        {
+            int id_user = -1;
+            int id_group = -1;
+            std::string space_id = "";
+            std::string organization_id = "";
+            long long issued = 0;
+            long long expiry = 0;
+        };
+
+        static bool Enabled_();
+        static std::string CookieName_();
+
+        // "user:group:space:organization:issued:expiry.signature"
+        static std::string Issue_(Claims claims);
+        static bool Verify_(std::string token, Claims& claims);
+
+        // Tokens of the user issued until now are rejected
+        static void RevokeUser_(int id_user);
+        static void RevokeAll_();
+
+    private:
+        static long long Ttl_();
+        static std::string Sign_(const std::string& payload);
+        static long long Now_();
+        static bool Equal_(const std::string& a, const std::string& b);
+
+        static std::mutex mutex_;
+        static std::map<int, long long> revoked_;
+        static long long revoked_all_;
+};
+
+#endif //STRUCTBX_TOOLS_SESSIONTOKEN
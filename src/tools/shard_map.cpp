@@ -0,0 +1,122 @@
+
+#include "tools/shard_map.h"
+
+using namespace StructBX::Tools;
+
+std::mutex ShardMap::mutex_;
+std::map<std::string, std::string> ShardMap::placement_;
+
+void ShardMap::Start_()
+{
+    // Placement table, spaces without a row are on the primary
+    auto action1 = NAF::Functions::Action("a1");
+    action1.set_sql_code(
+        "CREATE TABLE IF NOT EXISTS spaces_shards (" \
+            "id_space INT NOT NULL PRIMARY KEY" \
+            ",endpoint VARCHAR(100) NOT NULL" \
+        ")"
+    );
+    if(!RoutedAction::Prepared_(action1))
+    {
+        NAF::Tools::OutputLogger::Error_("ShardMap: Error creating spaces_shards table");
+        return;
+    }
+
+    auto action2 = NAF::Functions::Action("a2");
+    action2.set_sql_code("SELECT id_space, endpoint FROM spaces_shards");
+    if(!RoutedAction::Prepared_(action2))
+    {
+        NAF::Tools::OutputLogger::Error_("ShardMap: Error reading spaces_shards");
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    placement_.clear();
+    for(auto row : *action2.get_results())
+        placement_[row->ExtractField_("id_space")->ToString_()] = row->ExtractField_("endpoint")->ToString_();
+}
+
+std::string ShardMap::Locate_(std::string space_id)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto found = placement_.find(space_id);
+    if(found == placement_.end())
+        return "";
+
+    return found->second;
+}
+
+std::string ShardMap::Place_(std::string space_id)
+{
+    auto endpoints = ConnectionPool::Endpoints_();
+    if(endpoints.empty())
+        return "";
+
+    // Spaces on the primary have no row, the one being placed is not counted
+    long long total = 0;
+    auto spaces = NAF::Functions::Action("a1");
+    spaces.set_sql_code("SELECT COUNT(*) FROM spaces WHERE state != 'DELETED' AND id != ?");
+    spaces.AddParameter_("id", space_id, false);
+    if(RoutedAction::Prepared_(spaces) && !spaces.get_results()->First_()->IsNull_())
+        total = spaces.get_results()->First_()->Int_();
+
+    // Count spaces per endpoint, the primary included
+    std::string endpoint = "";
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::map<std::string, long long> counts;
+        counts[""] = std::max<long long>(0, total - static_cast<long long>(placement_.size()));
+        for(auto& it : endpoints)
+            counts[it] = 0;
+        for(auto& it : placement_)
+            counts[it.second]++;
+
+        for(auto& it : counts)
+        {
+            if(it.second < counts[endpoint])
+                endpoint = it.first;
+        }
+    }
+    if(endpoint == "")
+        return "";
+
+    auto action = NAF::Functions::Action("a1");
+    action.set_sql_code("REPLACE INTO spaces_shards (id_space, endpoint) VALUES (?, ?)");
+    action.AddParameter_("id_space", space_id, false);
+    action.AddParameter_("endpoint", endpoint, false);
+    if(!RoutedAction::Prepared_(action))
+    {
+        NAF::Tools::OutputLogger::Error_("ShardMap: Error placing space " + space_id + ", using the primary");
+        return "";
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    placement_[space_id] = endpoint;
+    return endpoint;
+}
+
+void ShardMap::Forget_(std::string space_id)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    placement_.erase(space_id);
+}
+
+bool ShardMap::Work_(Functions::Action& action, std::string space_id)
+{
+    return RoutedAction::Work_(action, Locate_(space_id));
+}
+
+bool ShardMap::Work_(Functions::Action::Ptr action, std::string space_id)
+{
+    return RoutedAction::Work_(*action, Locate_(space_id));
+}
+
+bool ShardMap::Prepared_(Functions::Action& action, std::string space_id)
+{
+    return RoutedAction::Prepared_(action, Locate_(space_id));
+}
+
+bool ShardMap::Prepared_(Functions::Action::Ptr action, std::string space_id)
+{
+    return RoutedAction::Prepared_(*action, Locate_(space_id));
+}
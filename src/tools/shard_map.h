@@ -0,0 +1,56 @@
+
+#ifndef STRUCTBX_TOOLS_SHARDMAP
+#define STRUCTBX_TOOLS_SHARDMAP
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <algorithm>
+
+#include "core/nebula_atom.h"
+#include "functions/action.h"
+#include <tools/output_logger.h>
+
+#include "tools/connection_pool.h"
+#include "tools/routed_action.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class ShardMap;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::ShardMap
+{
+    public:
+        static void Start_();
+
+        // ConnectionPool endpoint that holds the database of a space, "" is the primary
+        static std::string Locate_(std::string space_id);
+
+        // New spaces go to the endpoint with fewer spaces
+        static std::string Place_(std::string space_id);
+
+        // Drops the placement of a space whose database could not be created,
+        // the spaces_shards row is deleted by the caller
+        static void Forget_(std::string space_id);
+
+        // Runs queries on _structbx_space_<id>, metadata stays on the primary
+        static bool Work_(Functions::Action& action, std::string space_id);
+        static bool Work_(Functions::Action::Ptr action, std::string space_id);
+
+        // Same with a cached prepared statement, also on the primary
+        static bool Prepared_(Functions::Action& action, std::string space_id);
+        static bool Prepared_(Functions::Action::Ptr action, std::string space_id);
+
+    private:
+        static std::mutex mutex_;
+        static std::map<std::string, std::string> placement_;
+};
+
+#endif //STRUCTBX_TOOLS_SHARDMAP
@@ -0,0 +1,198 @@
+
+#include "tools/space_scheduler.h"
+
+using namespace StructBX::Tools;
+
+bool SpaceScheduler::enabled_ = false;
+std::size_t SpaceScheduler::capacity_ = 64;
+std::size_t SpaceScheduler::in_flight_ = 0;
+std::size_t SpaceScheduler::default_limit_ = 8;
+double SpaceScheduler::virtual_time_ = 0;
+std::chrono::milliseconds SpaceScheduler::wait_(5000);
+std::map<std::string, std::pair<std::size_t, double>> SpaceScheduler::overrides_;
+std::map<std::string, SpaceScheduler::Space> SpaceScheduler::spaces_;
+std::mutex SpaceScheduler::mutex_;
+
+SpaceScheduler::Ticket::Ticket(std::string space_id) :
+    space_id_(space_id)
+    ,admitted_(true)
+    ,start_(std::chrono::steady_clock::now())
+{
+    if(enabled_ && space_id_ != "")
+    {
+        admitted_ = Acquire_(space_id_);
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+SpaceScheduler::Ticket::~Ticket()
+{
+    if(enabled_ && space_id_ != "" && admitted_)
+        Release_(space_id_, std::chrono::steady_clock::now() - start_);
+}
+
+void SpaceScheduler::Start_()
+{
+    // Settings
+    enabled_ = NAF::Tools::SettingsManager::GetSetting_("space_scheduler", "false") == "true";
+    try
+    {
+        capacity_ = std::max(1ul, std::stoul(NAF::Tools::SettingsManager::GetSetting_("space_scheduler_capacity", "64")));
+        default_limit_ = std::max(1ul, std::stoul(NAF::Tools::SettingsManager::GetSetting_("space_concurrency_limit", "8")));
+        wait_ = std::chrono::milliseconds(std::stoi(NAF::Tools::SettingsManager::GetSetting_("space_scheduler_wait_ms", "5000")));
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("SpaceScheduler: space_scheduler_capacity, space_concurrency_limit and space_scheduler_wait_ms must be integers");
+    }
+
+    // Per space overrides: "id=limit/weight,id=limit/weight"
+    std::stringstream overrides(NAF::Tools::SettingsManager::GetSetting_("space_limits", ""));
+    std::string entry;
+    while(std::getline(overrides, entry, ','))
+    {
+        auto equal = entry.find('=');
+        auto slash = entry.find('/');
+        try
+        {
+            if(equal == std::string::npos)
+                throw std::invalid_argument(entry);
+            auto limit = std::stoul(entry.substr(equal + 1, slash == std::string::npos ? std::string::npos : slash - equal - 1));
+            auto weight = slash == std::string::npos ? 1.0 : std::stod(entry.substr(slash + 1));
+            overrides_[entry.substr(0, equal)] = std::make_pair(std::max(1ul, limit), std::max(0.01, weight));
+        }
+        catch(std::exception&)
+        {
+            NAF::Tools::OutputLogger::Error_("SpaceScheduler: Invalid space limit \"" + entry + "\", expected id=limit/weight");
+        }
+    }
+}
+
+Poco::JSON::Object::Ptr SpaceScheduler::Metrics_()
+{
+    Poco::JSON::Object::Ptr metrics = new Poco::JSON::Object;
+    Poco::JSON::Object::Ptr spaces = new Poco::JSON::Object;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    metrics->set("enabled", enabled_);
+    metrics->set("capacity", capacity_);
+    metrics->set("in_flight", in_flight_);
+    for(auto& it : spaces_)
+    {
+        auto& space = it.second;
+        Poco::JSON::Object::Ptr object = new Poco::JSON::Object;
+        object->set("limit", space.limit);
+        object->set("weight", space.weight);
+        object->set("in_flight", space.in_flight);
+        object->set("waiting", space.waiting.size());
+        object->set("admitted", space.admitted);
+        object->set("rejected", space.rejected);
+        object->set("waits", space.waits);
+        object->set("wait_average_ms", space.waits == 0 ? 0.0 : space.wait_total.count() / 1000.0 / space.waits);
+        object->set("wait_max_ms", space.wait_max.count() / 1000.0);
+        spaces->set(it.first, object);
+    }
+    metrics->set("spaces", spaces);
+
+    return metrics;
+}
+
+bool SpaceScheduler::Acquire_(std::string space_id)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto& space = Space_(space_id);
+
+    // A space that was idle starts at the current virtual time, it banks no credit
+    if(space.in_flight == 0 && space.waiting.empty())
+        space.virtual_time = std::max(space.virtual_time, virtual_time_);
+
+    // Nobody is ahead, run now
+    bool queued = false;
+    for(auto& it : spaces_)
+        queued = queued || !it.second.waiting.empty();
+    if(!queued && space.in_flight < space.limit && in_flight_ < capacity_)
+    {
+        space.in_flight++;
+        space.admitted++;
+        in_flight_++;
+        return true;
+    }
+
+    Waiter waiter;
+    space.waiting.push_back(&waiter);
+    Grant_();
+    waiter.condition.wait_for(lock, wait_, [&waiter]{ return waiter.granted; });
+
+    auto& current = Space_(space_id);
+    if(!waiter.granted)
+    {
+        current.waiting.remove(&waiter);
+        current.rejected++;
+        return false;
+    }
+
+    auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    current.admitted++;
+    current.waits++;
+    current.wait_total += waited;
+    current.wait_max = std::max(current.wait_max, waited);
+    return true;
+}
+
+void SpaceScheduler::Release_(std::string space_id, std::chrono::steady_clock::duration used)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto& space = Space_(space_id);
+    space.in_flight--;
+    in_flight_--;
+
+    // The time used moves the space back in the queue, weighted
+    space.virtual_time += std::chrono::duration<double>(used).count() / space.weight;
+    Grant_();
+}
+
+SpaceScheduler::Space& SpaceScheduler::Space_(std::string space_id)
+{
+    auto found = spaces_.find(space_id);
+    if(found != spaces_.end())
+        return found->second;
+
+    auto& space = spaces_[space_id];
+    space.limit = default_limit_;
+    auto configured = overrides_.find(space_id);
+    if(configured != overrides_.end())
+    {
+        space.limit = configured->second.first;
+        space.weight = configured->second.second;
+    }
+
+    return space;
+}
+
+void SpaceScheduler::Grant_()
+{
+    // Free slots go to the waiting space with the lowest virtual time
+    while(in_flight_ < capacity_)
+    {
+        Space* next = nullptr;
+        for(auto& it : spaces_)
+        {
+            auto& space = it.second;
+            if(space.waiting.empty() || space.in_flight >= space.limit)
+                continue;
+            if(next == nullptr || space.virtual_time < next->virtual_time)
+                next = &space;
+        }
+        if(next == nullptr)
+            return;
+
+        auto waiter = next->waiting.front();
+        next->waiting.pop_front();
+        next->in_flight++;
+        in_flight_++;
+        virtual_time_ = std::max(virtual_time_, next->virtual_time);
+        waiter->granted = true;
+        waiter->condition.notify_one();
+    }
+}
@@ -0,0 +1,95 @@
+
+#ifndef STRUCTBX_TOOLS_SPACESCHEDULER
+#define STRUCTBX_TOOLS_SPACESCHEDULER
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+#include <condition_variable>
+
+#include "Poco/JSON/Object.h"
+
+#include "core/nebula_atom.h"
+#include <tools/output_logger.h>
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class SpaceScheduler;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+// Weighted fair queue of requests per space, a space that used more time waits behind
+// the others and never runs more than its limit at once
+class StructBX::Tools::SpaceScheduler
+{
+    public:
+        // Holds a slot of the space while the request runs
+        class Ticket
+        {
+            public:
+                Ticket(std::string space_id);
+                ~Ticket();
+
+                bool Admitted_() const { return admitted_; }
+
+            private:
+                std::string space_id_;
+                bool admitted_;
+                std::chrono::steady_clock::time_point start_;
+        };
+
+        static void Start_();
+        static bool Enabled_() { return enabled_; }
+
+        // Slots in use, waiting requests and time spent waiting per space
+        static Poco::JSON::Object::Ptr Metrics_();
+
+    private:
+        struct Waiter
+        {
+            std::condition_variable condition;
+            bool granted = false;
+        };
+
+        struct Space
+        {
+            std::size_t limit = 8;
+            double weight = 1;
+            double virtual_time = 0;
+            std::size_t in_flight = 0;
+            std::list<Waiter*> waiting;
+
+            // Metrics
+            unsigned long long admitted = 0;
+            unsigned long long rejected = 0;
+            unsigned long long waits = 0;
+            std::chrono::microseconds wait_total{0};
+            std::chrono::microseconds wait_max{0};
+        };
+
+        static bool Acquire_(std::string space_id);
+        static void Release_(std::string space_id, std::chrono::steady_clock::duration used);
+        static Space& Space_(std::string space_id);
+        static void Grant_();
+
+        static bool enabled_;
+        static std::size_t capacity_;
+        static std::size_t in_flight_;
+        static std::size_t default_limit_;
+        static double virtual_time_;
+        static std::chrono::milliseconds wait_;
+        static std::map<std::string, std::pair<std::size_t, double>> overrides_;
+        static std::map<std::string, Space> spaces_;
+        static std::mutex mutex_;
+};
+
+#endif //STRUCTBX_TOOLS_SPACESCHEDULER
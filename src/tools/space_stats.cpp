@@ -0,0 +1,281 @@
+
+#include "tools/space_stats.h"
+
+using namespace StructBX::Tools;
+
+std::mutex SpaceStats::mutex_;
+std::map<std::string, SpaceStats::Stats> SpaceStats::stats_;
+std::set<std::string> SpaceStats::dirty_;
+std::map<int, std::pair<std::string, std::string>> SpaceStats::watches_;
+std::condition_variable SpaceStats::condition_;
+std::thread SpaceStats::worker_;
+std::thread SpaceStats::watcher_;
+bool SpaceStats::running_ = false;
+int SpaceStats::inotify_fd_ = -1;
+int SpaceStats::interval_ = 300;
+std::string SpaceStats::directory_ = "/var/www/structbx-web-uploaded";
+
+void SpaceStats::Start_()
+{
+    // Settings
+    directory_ = NAF::Tools::SettingsManager::GetSetting_("directory_for_uploaded_files", "/var/www/structbx-web-uploaded");
+    try
+    {
+        interval_ = std::stoi(NAF::Tools::SettingsManager::GetSetting_("space_stats_interval", "300"));
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("SpaceStats: space_stats_interval must be an integer");
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(running_)
+        return;
+    running_ = true;
+
+    // Watch the upload directories, without inotify only the schedule refreshes
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotify_fd_ < 0)
+        NAF::Tools::OutputLogger::Error_("SpaceStats: inotify is not available, refreshing on schedule only");
+    else
+    {
+        lock.unlock();
+        Watch_(directory_, "");
+        lock.lock();
+        watcher_ = std::thread(&SpaceStats::WatchWork_);
+    }
+
+    worker_ = std::thread(&SpaceStats::Work_);
+}
+
+void SpaceStats::Stop_()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(!running_)
+            return;
+        running_ = false;
+    }
+    condition_.notify_all();
+    if(worker_.joinable())
+        worker_.join();
+    if(watcher_.joinable())
+        watcher_.join();
+    if(inotify_fd_ >= 0)
+    {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+}
+
+SpaceStats::Stats SpaceStats::Get_(std::string space_id)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto found = stats_.find(space_id);
+        if(found != stats_.end())
+            return found->second;
+    }
+
+    auto stats = Measure_(space_id);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    stats_[space_id] = stats;
+    return stats;
+}
+
+void SpaceStats::MarkDirty_(std::string space_id)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        dirty_.insert(space_id);
+    }
+    condition_.notify_all();
+}
+
+SpaceStats::Stats SpaceStats::Measure_(std::string space_id)
+{
+    Stats stats;
+
+    // Size of space database
+    auto action = NAF::Functions::Action("a1");
+    action.set_sql_code(
+        "SELECT ROUND(SUM((DATA_LENGTH + INDEX_LENGTH)) / 1024 / 1024, 2) AS 'size' " \
+        "FROM information_schema.TABLES " \
+        "WHERE TABLE_SCHEMA = ?"
+    );
+    action.AddParameter_("schema", "_structbx_space_" + space_id, false);
+    if(ShardMap::Prepared_(action, space_id))
+    {
+        auto size = action.get_results()->First_();
+        if(!size->IsNull_())
+            stats.size = size->Float_();
+    }
+    else
+        NAF::Tools::OutputLogger::Error_("SpaceStats: Error reading database size of space " + space_id);
+
+    // Size of space directory
+    stats.directory_size = DirectorySize_(directory_ + "/" + space_id) / 1024.f / 1024.f;
+
+    return stats;
+}
+
+float SpaceStats::DirectorySize_(std::string path)
+{
+    float size = 0;
+    try
+    {
+        Poco::DirectoryIterator it(path);
+        Poco::DirectoryIterator end;
+        for(; it != end; ++it)
+        {
+            if(it->isLink())
+                continue;
+            if(it->isDirectory())
+                size += DirectorySize_(it->path());
+            else
+                size += it->getSize();
+        }
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Debug_("SpaceStats: " + std::string(e.what()));
+    }
+
+    return size;
+}
+
+void SpaceStats::Watch_(std::string path, std::string space_id)
+{
+    if(inotify_fd_ < 0)
+        return;
+
+    int wd = inotify_add_watch(inotify_fd_, path.c_str(), IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO);
+    if(wd < 0)
+    {
+        NAF::Tools::OutputLogger::Debug_("SpaceStats: Could not watch " + path);
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        watches_[wd] = std::make_pair(path, space_id);
+    }
+
+    // inotify is not recursive, watch every subdirectory
+    try
+    {
+        Poco::DirectoryIterator it(path);
+        Poco::DirectoryIterator end;
+        for(; it != end; ++it)
+        {
+            if(it->isDirectory() && !it->isLink())
+                Watch_(it->path(), space_id == "" ? it.name() : space_id);
+        }
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Debug_("SpaceStats: " + std::string(e.what()));
+    }
+}
+
+void SpaceStats::Work_()
+{
+    // Warm up every space
+    auto action = NAF::Functions::Action("a1");
+    action.set_sql_code("SELECT id FROM spaces");
+    if(RoutedAction::Prepared_(action))
+    {
+        for(auto row : *action.get_results())
+        {
+            auto id = row->ExtractField_("id");
+            if(id->IsNull_())
+                continue;
+
+            auto stats = Measure_(id->ToString_());
+            std::unique_lock<std::mutex> lock(mutex_);
+            if(!running_)
+                return;
+            stats_[id->ToString_()] = stats;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto next_refresh = std::chrono::steady_clock::now() + std::chrono::seconds(interval_);
+    while(running_)
+    {
+        condition_.wait_until(lock, next_refresh, []{ return !running_ || !dirty_.empty(); });
+        if(!running_)
+            break;
+
+        // Let bursts of file events settle before measuring
+        if(!dirty_.empty())
+            condition_.wait_for(lock, std::chrono::seconds(1), []{ return !running_; });
+
+        std::set<std::string> spaces;
+        spaces.swap(dirty_);
+        if(std::chrono::steady_clock::now() >= next_refresh)
+        {
+            for(auto& it : stats_)
+                spaces.insert(it.first);
+            next_refresh = std::chrono::steady_clock::now() + std::chrono::seconds(interval_);
+        }
+
+        for(auto& space_id : spaces)
+        {
+            lock.unlock();
+            auto stats = Measure_(space_id);
+            lock.lock();
+            stats_[space_id] = stats;
+        }
+    }
+}
+
+void SpaceStats::WatchWork_()
+{
+    alignas(struct inotify_event) char buffer[4096];
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if(!running_)
+                break;
+        }
+
+        struct pollfd pfd = {inotify_fd_, POLLIN, 0};
+        if(poll(&pfd, 1, 500) <= 0)
+            continue;
+
+        auto length = read(inotify_fd_, buffer, sizeof(buffer));
+        if(length <= 0)
+            continue;
+
+        for(char* ptr = buffer; ptr < buffer + length;)
+        {
+            auto event = reinterpret_cast<struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            std::pair<std::string, std::string> watch;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                auto found = watches_.find(event->wd);
+                if(found == watches_.end())
+                    continue;
+                if(event->mask & IN_IGNORED)
+                {
+                    watches_.erase(found);
+                    continue;
+                }
+                watch = found->second;
+            }
+
+            // New space or form directories are watched too
+            std::string name = event->len > 0 ? std::string(event->name) : "";
+            std::string space_id = watch.second == "" ? name : watch.second;
+            if((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+                Watch_(watch.first + "/" + name, space_id);
+
+            if(space_id != "")
+                MarkDirty_(space_id);
+        }
+    }
+}
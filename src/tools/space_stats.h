@@ -0,0 +1,73 @@
+
+#ifndef STRUCTBX_TOOLS_SPACESTATS
+#define STRUCTBX_TOOLS_SPACESTATS
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <chrono>
+#include <condition_variable>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "Poco/File.h"
+#include "Poco/DirectoryIterator.h"
+
+#include "core/nebula_atom.h"
+#include "functions/action.h"
+#include <tools/output_logger.h>
+
+#include "tools/shard_map.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class SpaceStats;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::SpaceStats
+{
+    public:
+        struct Stats
+        {
+            float size = 0;
+            float directory_size = 0;
+        };
+
+        static void Start_();
+        static void Stop_();
+
+        // Served from memory, measured on the first request of a space
+        static Stats Get_(std::string space_id);
+        static void MarkDirty_(std::string space_id);
+
+    private:
+        static Stats Measure_(std::string space_id);
+        static float DirectorySize_(std::string path);
+        static void Watch_(std::string path, std::string space_id);
+        static void Work_();
+        static void WatchWork_();
+
+        static std::mutex mutex_;
+        static std::map<std::string, Stats> stats_;
+        static std::set<std::string> dirty_;
+        static std::map<int, std::pair<std::string, std::string>> watches_;
+        static std::condition_variable condition_;
+        static std::thread worker_;
+        static std::thread watcher_;
+        static bool running_;
+        static int inotify_fd_;
+        static int interval_;
+        static std::string directory_;
+};
+
+#endif //STRUCTBX_TOOLS_SPACESTATS
@@ -0,0 +1,118 @@
+
+#include "tools/statement_cache.h"
+
+using namespace StructBX::Tools;
+
+std::size_t StatementCache::capacity_ = 64;
+std::atomic<unsigned long long> StatementCache::hits_(0);
+std::atomic<unsigned long long> StatementCache::misses_(0);
+std::atomic<unsigned long long> StatementCache::evictions_(0);
+
+StatementCache::Entry::Entry(Poco::Data::Session& session, std::string sql, std::size_t parameters) :
+    values(parameters)
+    ,statement(session)
+{
+    statement << sql;
+    for(auto& value : values)
+        statement, Poco::Data::Keywords::use(value);
+}
+
+StatementCache::StatementCache()
+{
+
+}
+
+StatementCache::Entry& StatementCache::Get_(Poco::Data::Session& session, std::string sql, std::size_t parameters)
+{
+    auto found = entries_.find(sql);
+    if(found != entries_.end() && found->second->second->values.size() == parameters)
+    {
+        hits_++;
+        order_.splice(order_.begin(), order_, found->second);
+        return *found->second->second;
+    }
+    misses_++;
+    if(found != entries_.end())
+        Erase_(sql);
+
+    // Evict the least recently used
+    while(entries_.size() >= capacity_)
+    {
+        entries_.erase(order_.back().first);
+        order_.pop_back();
+        evictions_++;
+    }
+
+    order_.emplace_front(sql, std::make_shared<Entry>(session, sql, parameters));
+    entries_[sql] = order_.begin();
+
+    return *order_.front().second;
+}
+
+StatementCache::Entry& StatementCache::Execute_(Poco::Data::Session& session, std::string sql, std::vector<Poco::Nullable<std::string>>& values, bool retry)
+{
+    while(true)
+    {
+        auto& entry = Get_(session, sql, values.size());
+        std::copy(values.begin(), values.end(), entry.values.begin());
+        try
+        {
+            entry.statement.execute();
+            entry.executions++;
+            return entry;
+        }
+        catch(Poco::Exception& e)
+        {
+            auto cached = entry.executions > 0;
+            Erase_(sql);
+            if(!retry || !cached || !Reprepare_(e.displayText()))
+                throw;
+        }
+        catch(std::exception&)
+        {
+            Erase_(sql);
+            throw;
+        }
+    }
+}
+
+bool StatementCache::Reprepare_(const std::string& error)
+{
+    // ER_UNKNOWN_STMT_HANDLER and ER_NEED_REPREPARE, the statement was not executed
+    return error.find("[mysql_stmt_errno]: 1243") != std::string::npos
+        || error.find("[mysql_stmt_errno]: 1615") != std::string::npos;
+}
+
+void StatementCache::Erase_(std::string sql)
+{
+    auto found = entries_.find(sql);
+    if(found == entries_.end())
+        return;
+
+    order_.erase(found->second);
+    entries_.erase(found);
+}
+
+void StatementCache::Start_()
+{
+    // Settings
+    try
+    {
+        capacity_ = std::max<std::size_t>(1, std::stoul(NAF::Tools::SettingsManager::GetSetting_("db_statement_cache_size", "64")));
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("StatementCache: db_statement_cache_size must be an integer");
+    }
+}
+
+Poco::JSON::Object::Ptr StatementCache::Metrics_()
+{
+    Poco::JSON::Object::Ptr metrics = new Poco::JSON::Object;
+    metrics->set("capacity", capacity_);
+    metrics->set("hits", hits_.load());
+    metrics->set("misses", misses_.load());
+    metrics->set("evictions", evictions_.load());
+
+    return metrics;
+}
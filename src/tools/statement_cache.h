@@ -0,0 +1,78 @@
+
+#ifndef STRUCTBX_TOOLS_STATEMENTCACHE
+#define STRUCTBX_TOOLS_STATEMENTCACHE
+
+#include <list>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Poco/Nullable.h"
+#include "Poco/Exception.h"
+#include "Poco/Data/Session.h"
+#include "Poco/Data/Statement.h"
+#include "Poco/JSON/Object.h"
+
+#include "core/nebula_atom.h"
+#include <tools/output_logger.h>
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class StatementCache;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+// Prepared statements of one connection, the least recently used is closed first
+class StructBX::Tools::StatementCache
+{
+    public:
+        struct Entry
+        {
+            Entry(Poco::Data::Session& session, std::string sql, std::size_t parameters);
+
+            // Bound by reference, set the values and execute again
+            std::vector<Poco::Nullable<std::string>> values;
+            Poco::Data::Statement statement;
+            unsigned long long executions = 0;
+        };
+
+        StatementCache();
+
+        // Prepares sql on a miss, MySQL parses it once per connection
+        Entry& Get_(Poco::Data::Session& session, std::string sql, std::size_t parameters);
+
+        // Copies the values and executes, with retry a cached statement the server no
+        // longer knows or asks to re-prepare is prepared again once. Any other error is
+        // thrown, the statement may have been applied already
+        Entry& Execute_(Poco::Data::Session& session, std::string sql, std::vector<Poco::Nullable<std::string>>& values, bool retry = true);
+
+        void Erase_(std::string sql);
+
+        static void Start_();
+
+        // Hits, misses and evictions of all connections
+        static Poco::JSON::Object::Ptr Metrics_();
+
+    private:
+        static bool Reprepare_(const std::string& error);
+
+        using Order = std::list<std::pair<std::string, std::shared_ptr<Entry>>>;
+
+        Order order_;
+        std::unordered_map<std::string, Order::iterator> entries_;
+
+        static std::size_t capacity_;
+        static std::atomic<unsigned long long> hits_;
+        static std::atomic<unsigned long long> misses_;
+        static std::atomic<unsigned long long> evictions_;
+};
+
+#endif //STRUCTBX_TOOLS_STATEMENTCACHE
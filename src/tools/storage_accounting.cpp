@@ -0,0 +1,211 @@
+
+#include "tools/storage_accounting.h"
+
+using namespace StructBX::Tools;
+
+std::mutex StorageAccounting::mutex_;
+std::map<std::string, long long> StorageAccounting::spaces_;
+std::map<std::string, long long> StorageAccounting::forms_;
+long long StorageAccounting::quota_ = 0;
+
+void StorageAccounting::Start_()
+{
+    // Settings
+    try
+    {
+        quota_ = std::stoll(NAF::Tools::SettingsManager::GetSetting_("space_quota_mb", "0")) * 1024 * 1024;
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("StorageAccounting: space_quota_mb must be an integer");
+    }
+
+    // Accounting table
+    auto action = NAF::Functions::Action("a1");
+    action.set_sql_code(
+        "CREATE TABLE IF NOT EXISTS storage_usage (" \
+            "id_space INT NOT NULL" \
+            ",id_form INT NOT NULL" \
+            ",bytes BIGINT NOT NULL DEFAULT 0" \
+            ",PRIMARY KEY (id_space, id_form)" \
+        ")"
+    );
+    if(!RoutedAction::Prepared_(action))
+    {
+        NAF::Tools::OutputLogger::Error_("StorageAccounting: Error creating storage_usage table");
+        return;
+    }
+
+    // First start: measure what is already on disk, once
+    if(!Load_())
+    {
+        Rebuild_();
+        auto action2 = NAF::Functions::Action("a2");
+        action2.set_sql_code("REPLACE INTO storage_usage (id_space, id_form, bytes) VALUES (0, 0, 0)");
+        if(!RoutedAction::Prepared_(action2))
+            NAF::Tools::OutputLogger::Error_("StorageAccounting: Error marking storage_usage as rebuilt");
+        Load_();
+    }
+}
+
+void StorageAccounting::AddBytes_(std::string space_id, std::string form_id, long long bytes)
+{
+    if(bytes == 0)
+        return;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Add_(space_id, form_id, bytes);
+    }
+    Write_(space_id, form_id, bytes);
+}
+
+bool StorageAccounting::Reserve_(std::string space_id, std::string form_id, long long bytes)
+{
+    // Checked and added under one lock, concurrent uploads can't pass the quota together
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(quota_ > 0 && spaces_[space_id] + bytes > quota_)
+            return false;
+        if(bytes == 0)
+            return true;
+        Add_(space_id, form_id, bytes);
+    }
+    Write_(space_id, form_id, bytes);
+
+    return true;
+}
+
+void StorageAccounting::Add_(std::string space_id, std::string form_id, long long bytes)
+{
+    auto& form_bytes = forms_[space_id + "/" + form_id];
+    auto previous = form_bytes;
+    form_bytes = std::max(0LL, form_bytes + bytes);
+    spaces_[space_id] += form_bytes - previous;
+}
+
+void StorageAccounting::Write_(std::string space_id, std::string form_id, long long bytes)
+{
+    // Usage never goes below zero, files may be removed twice
+    auto action = NAF::Functions::Action("a1");
+    action.set_sql_code(
+        "INSERT INTO storage_usage (id_space, id_form, bytes) VALUES (?, ?, GREATEST(?, 0)) " \
+        "ON DUPLICATE KEY UPDATE bytes = GREATEST(CAST(bytes AS SIGNED) + ?, 0)"
+    );
+    action.AddParameter_("id_space", space_id, false);
+    action.AddParameter_("id_form", form_id, false);
+    action.AddParameter_("bytes", std::to_string(bytes), false);
+    action.AddParameter_("bytes", std::to_string(bytes), false);
+    if(!RoutedAction::Prepared_(action))
+        NAF::Tools::OutputLogger::Error_("StorageAccounting: Error writing usage of space " + space_id);
+}
+
+long long StorageAccounting::SpaceBytes_(std::string space_id)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto found = spaces_.find(space_id);
+    if(found == spaces_.end())
+        return 0;
+
+    return found->second;
+}
+
+long long StorageAccounting::FormBytes_(std::string space_id, std::string form_id)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto found = forms_.find(space_id + "/" + form_id);
+    if(found == forms_.end())
+        return 0;
+
+    return found->second;
+}
+
+bool StorageAccounting::Load_()
+{
+    auto action = NAF::Functions::Action("a1");
+    action.set_sql_code("SELECT id_space, id_form, bytes FROM storage_usage");
+    if(!RoutedAction::Prepared_(action))
+        return false;
+
+    // The row of space 0 marks that the usage on disk was measured, even if there was none
+    bool rebuilt = false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    spaces_.clear();
+    forms_.clear();
+    for(auto row : *action.get_results())
+    {
+        auto id_space = row->ExtractField_("id_space")->ToString_();
+        auto id_form = row->ExtractField_("id_form")->ToString_();
+        if(id_space == "0")
+        {
+            rebuilt = true;
+            continue;
+        }
+        auto bytes = std::stoll(row->ExtractField_("bytes")->ToString_());
+        spaces_[id_space] += bytes;
+        forms_[id_space + "/" + id_form] = bytes;
+    }
+
+    return rebuilt;
+}
+
+void StorageAccounting::Rebuild_()
+{
+    // Upload directories are <directory>/<space>/<form>, files on the space directory belong to form 0
+    auto directory = NAF::Tools::SettingsManager::GetSetting_("directory_for_uploaded_files", "/var/www/structbx-web-uploaded");
+    try
+    {
+        Poco::DirectoryIterator space_it(directory);
+        Poco::DirectoryIterator end;
+        for(; space_it != end; ++space_it)
+        {
+            if(!space_it->isDirectory())
+                continue;
+
+            std::map<std::string, long long> forms;
+            Poco::DirectoryIterator form_it(space_it->path());
+            for(; form_it != end; ++form_it)
+            {
+                if(form_it->isLink())
+                    continue;
+                if(form_it->isDirectory())
+                    forms[form_it.name()] += DirectoryBytes_(form_it->path());
+                else
+                    forms["0"] += form_it->getSize();
+            }
+
+            for(auto& form : forms)
+            {
+                auto action = NAF::Functions::Action("a1");
+                action.set_sql_code("REPLACE INTO storage_usage (id_space, id_form, bytes) VALUES (?, ?, ?)");
+                action.AddParameter_("id_space", space_it.name(), false);
+                action.AddParameter_("id_form", form.first, false);
+                action.AddParameter_("bytes", std::to_string(form.second), false);
+                if(!RoutedAction::Prepared_(action))
+                    NAF::Tools::OutputLogger::Error_("StorageAccounting: Error writing usage of space " + space_it.name());
+            }
+        }
+    }
+    catch(std::exception& e)
+    {
+        NAF::Tools::OutputLogger::Error_("StorageAccounting: " + std::string(e.what()));
+    }
+}
+
+long long StorageAccounting::DirectoryBytes_(std::string path)
+{
+    long long bytes = 0;
+    Poco::DirectoryIterator it(path);
+    Poco::DirectoryIterator end;
+    for(; it != end; ++it)
+    {
+        if(it->isLink())
+            continue;
+        if(it->isDirectory())
+            bytes += DirectoryBytes_(it->path());
+        else
+            bytes += it->getSize();
+    }
+
+    return bytes;
+}
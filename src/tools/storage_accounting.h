@@ -0,0 +1,57 @@
+
+#ifndef STRUCTBX_TOOLS_STORAGEACCOUNTING
+#define STRUCTBX_TOOLS_STORAGEACCOUNTING
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <algorithm>
+
+#include "Poco/File.h"
+#include "Poco/DirectoryIterator.h"
+
+#include "core/nebula_atom.h"
+#include "functions/action.h"
+#include <tools/output_logger.h>
+
+#include "tools/routed_action.h"
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class StorageAccounting;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::StorageAccounting
+{
+    public:
+        static void Start_();
+
+        // Uploaded bytes per space and per form, form "0" is the space itself
+        static void AddBytes_(std::string space_id, std::string form_id, long long bytes);
+        static long long SpaceBytes_(std::string space_id);
+        static long long FormBytes_(std::string space_id, std::string form_id);
+
+        // Adds the bytes if the space can store them without exceeding space_quota_mb,
+        // AddBytes_ with the negative amount gives them back
+        static bool Reserve_(std::string space_id, std::string form_id, long long bytes);
+
+    private:
+        static void Add_(std::string space_id, std::string form_id, long long bytes);
+        static void Write_(std::string space_id, std::string form_id, long long bytes);
+        static bool Load_();
+        static void Rebuild_();
+        static long long DirectoryBytes_(std::string path);
+
+        static std::mutex mutex_;
+        static std::map<std::string, long long> spaces_;
+        static std::map<std::string, long long> forms_;
+        static long long quota_;
+};
+
+#endif //STRUCTBX_TOOLS_STORAGEACCOUNTING
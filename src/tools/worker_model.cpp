@@ -0,0 +1,67 @@
+
+#include "tools/worker_model.h"
+
+using namespace StructBX::Tools;
+
+bool WorkerModel::bounded_ = false;
+unsigned int WorkerModel::workers_ = 0;
+unsigned int WorkerModel::blocking_threads_ = 0;
+std::atomic<unsigned int> WorkerModel::in_flight_(0);
+
+void WorkerModel::Configure_()
+{
+    auto mode = NAF::Tools::SettingsManager::GetSetting_("server_mode", "threads");
+    if(mode != "bounded")
+    {
+        if(mode != "threads")
+            NAF::Tools::OutputLogger::Error_("WorkerModel: Unknown server_mode \"" + mode + "\", using threads");
+        return;
+    }
+    bounded_ = true;
+
+    // Settings, 0 workers is one per core
+    int max_queued = 16384;
+    try
+    {
+        workers_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("server_workers", "0"));
+        blocking_threads_ = std::stoul(NAF::Tools::SettingsManager::GetSetting_("server_blocking_threads", "64"));
+        max_queued = std::stoi(NAF::Tools::SettingsManager::GetSetting_("server_max_queued", "16384"));
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("WorkerModel: server_workers, server_blocking_threads and server_max_queued must be integers");
+    }
+    if(workers_ == 0)
+        workers_ = std::max(1u, std::thread::hardware_concurrency());
+
+    // Core sized workers plus a bounded number of threads that may block on I/O,
+    // the pool starts small and grows up to this on demand. Queued connections hold no thread
+    auto max_threads = static_cast<int>(workers_ + blocking_threads_);
+    NAF::Tools::SettingsManager::AddSetting_("max_threads", NAF::Tools::DValue::Type::kInt, NAF::Tools::DValue(max_threads));
+    NAF::Tools::SettingsManager::AddSetting_("max_queued", NAF::Tools::DValue::Type::kInt, NAF::Tools::DValue(max_queued));
+
+    SetupStack_();
+
+    NAF::Tools::OutputLogger::Debug_(
+        "WorkerModel: bounded, " + std::to_string(workers_) + " workers, " + std::to_string(blocking_threads_) +
+        " blocking threads, " + std::to_string(max_queued) + " queued connections"
+    );
+}
+
+void WorkerModel::SetupStack_()
+{
+    // Only the server pool reserves this instead of the 8 MB default, the threads
+    // of AsyncQuery, ActionGraph, imports and cleanup keep the system default
+    std::size_t stack_size = 1024 * 1024;
+    try
+    {
+        stack_size = std::stoul(NAF::Tools::SettingsManager::GetSetting_("server_thread_stack_kb", "1024")) * 1024;
+    }
+    catch(std::exception&)
+    {
+        NAF::Tools::OutputLogger::Error_("WorkerModel: server_thread_stack_kb must be an integer");
+    }
+    stack_size = std::max<std::size_t>(stack_size, PTHREAD_STACK_MIN);
+
+    Poco::ThreadPool::defaultPool().setStackSize(static_cast<int>(stack_size));
+}
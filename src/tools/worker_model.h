@@ -0,0 +1,60 @@
+
+#ifndef STRUCTBX_TOOLS_WORKERMODEL
+#define STRUCTBX_TOOLS_WORKERMODEL
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <climits>
+#include <algorithm>
+
+#include <pthread.h>
+
+#include <Poco/ThreadPool.h>
+
+#include "core/nebula_atom.h"
+#include <tools/output_logger.h>
+
+namespace StructBX
+{
+    namespace Tools
+    {
+        class WorkerModel;
+    }
+}
+
+using namespace StructBX;
+using namespace NAF;
+
+class StructBX::Tools::WorkerModel
+{
+    public:
+        // Counts the handlers in flight
+        class Scope
+        {
+            public:
+                Scope() { in_flight_++; }
+                ~Scope() { in_flight_--; }
+        };
+
+        // server_mode "threads" keeps max_threads and max_queued as configured,
+        // "bounded" sizes the server before NAF reads them
+        static void Configure_();
+
+        static bool Bounded_() { return bounded_; }
+        static unsigned int Workers_() { return workers_; }
+
+        // False in bounded mode once every worker is busy, the response then closes
+        // the connection instead of holding a thread for an idle keep-alive
+        static bool KeepAlive_() { return !bounded_ || in_flight_.load() <= workers_; }
+
+    private:
+        static void SetupStack_();
+
+        static bool bounded_;
+        static unsigned int workers_;
+        static unsigned int blocking_threads_;
+        static std::atomic<unsigned int> in_flight_;
+};
+
+#endif //STRUCTBX_TOOLS_WORKERMODEL
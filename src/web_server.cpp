@@ -13,6 +13,10 @@ StructBX::Webserver::Webserver() :
 
 void StructBX::Webserver::Process_()
 {
+    StructBX::Tools::WorkerModel::Scope worker_scope;
+    if(!StructBX::Tools::WorkerModel::KeepAlive_())
+        get_http_server_response().value()->setKeepAlive(false);
+
     SetupHeaders_();
     file_manager_.AddBasicSupportedFiles_();
     auto method = GetMethod_(get_properties().method);
@@ -35,8 +39,16 @@ void StructBX::Webserver::Process_()
 
 void StructBX::Webserver::DownloadProcess_()
 {
-    // Manage the file
+    // Served from memory when cached
         auto& request = get_http_server_request().value();
+        auto asset = StructBX::Tools::AssetCache::Find_(request->getURI());
+        if(asset)
+        {
+            SendAsset_(*asset);
+            return;
+        }
+
+    // Manage the file
         file_manager_.set_operation_type(Files::OperationType::kDownload);
         file_manager_.get_files().push_back(file_manager_.CreateTempFile_(request->getURI()));
         auto& tmp_file = file_manager_.get_files().front();
@@ -56,8 +68,30 @@ void StructBX::Webserver::DownloadProcess_()
         }
         file_manager_.ProcessContentLength_();
 
-    // Reponse
+    // Keep it for the next requests
+        asset = StructBX::Tools::AssetCache::Load_(request->getURI(), tmp_file.get_content_type());
+        if(asset)
+        {
+            SendAsset_(*asset);
+            return;
+        }
+
+    // Validators, unchanged files are not sent again
         auto& response = get_http_server_response().value();
+        auto path = StructBX::Tools::AssetCache::Path_(request->getURI());
+        StructBX::Tools::AssetCache::Validator validator;
+        if(path != "" && StructBX::Tools::AssetCache::Validator_(path, validator))
+        {
+            SetupCaching_(validator, validator.etag, path);
+            if(NotModified_(validator, validator.etag))
+                return;
+        }
+
+    // Large files go from the page cache to the socket
+        if(path != "" && StructBX::Tools::FileSender::Send_(*request, *response, path, tmp_file.get_content_type()))
+            return;
+
+    // Reponse
         response->setStatus(HTTPResponse::HTTP_OK);
         response->setContentType(tmp_file.get_content_type());
         response->setContentLength(tmp_file.get_content_length());
@@ -67,3 +101,101 @@ void StructBX::Webserver::DownloadProcess_()
     // Download file
         file_manager_.DownloadFile_(out_reponse);
 }
+
+void StructBX::Webserver::SendAsset_(const StructBX::Tools::AssetCache::Asset& asset)
+{
+    auto& request = get_http_server_request().value();
+    auto& response = get_http_server_response().value();
+
+    // The gzip variant if the client takes it
+        bool gzip = asset.gzip != "" && request->get("Accept-Encoding", "").find("gzip") != std::string::npos;
+        auto& body = gzip ? asset.gzip : asset.body;
+        if(asset.gzip != "")
+            response->set("Vary", "Accept-Encoding");
+
+    // Each encoding is its own representation with its own tag
+        auto etag = asset.validator.etag;
+        if(gzip)
+            etag.insert(etag.size() - 1, "-gz");
+        SetupCaching_(asset.validator, etag, asset.path);
+        if(NotModified_(asset.validator, etag))
+            return;
+        if(gzip)
+            response->set("Content-Encoding", "gzip");
+
+    // Reponse
+        response->setStatus(HTTPResponse::HTTP_OK);
+        response->setContentType(asset.content_type);
+        response->setContentLength(body.size());
+        response->sendBuffer(body.data(), body.size());
+}
+
+void StructBX::Webserver::SetupCaching_(const StructBX::Tools::AssetCache::Validator& validator, std::string etag, std::string path)
+{
+    static std::string max_age = [](){
+        try
+        {
+            return std::to_string(std::stoll(NAF::Tools::SettingsManager::GetSetting_("asset_immutable_max_age", "31536000")));
+        }
+        catch(std::exception&)
+        {
+            NAF::Tools::OutputLogger::Error_("Webserver: asset_immutable_max_age must be an integer");
+            return std::string("31536000");
+        }
+    }();
+
+    auto& response = get_http_server_response().value();
+    response->set("ETag", etag);
+    response->set("Last-Modified", Poco::DateTimeFormatter::format(validator.modified, Poco::DateTimeFormat::HTTP_FORMAT));
+
+    // Hashed bundles never change, everything else is revalidated on each use
+    if(StructBX::Tools::AssetCache::Immutable_(path))
+        response->set("Cache-Control", "public, max-age=" + max_age + ", immutable");
+    else
+        response->set("Cache-Control", "no-cache");
+}
+
+bool StructBX::Webserver::NotModified_(const StructBX::Tools::AssetCache::Validator& validator, std::string etag)
+{
+    auto& request = get_http_server_request().value();
+    auto& response = get_http_server_response().value();
+
+    bool not_modified = false;
+    if(request->has("If-None-Match"))
+    {
+        // Takes precedence over If-Modified-Since, compared weakly as GET allows
+        auto opaque = etag.compare(0, 2, "W/") == 0 ? etag.substr(2) : etag;
+        Poco::StringTokenizer tags(request->get("If-None-Match"), ",", Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+        for(auto tag : tags)
+        {
+            if(tag.compare(0, 2, "W/") == 0)
+                tag = tag.substr(2);
+            if(tag == "*" || tag == opaque)
+            {
+                not_modified = true;
+                break;
+            }
+        }
+    }
+    else if(request->has("If-Modified-Since"))
+    {
+        try
+        {
+            int time_zone;
+            auto since = Poco::DateTimeParser::parse(Poco::DateTimeFormat::HTTP_FORMAT, request->get("If-Modified-Since"), time_zone);
+            not_modified = validator.modified.epochTime() <= since.timestamp().epochTime();
+        }
+        catch(std::exception&)
+        {
+            not_modified = false;
+        }
+    }
+
+    if(!not_modified)
+        return false;
+
+    // Poco sends only the headers for a 304
+    response->setStatus(HTTPResponse::HTTP_NOT_MODIFIED);
+    response->send();
+    return true;
+}
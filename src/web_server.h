@@ -3,9 +3,18 @@
 #ifndef STRUCTBX_WEBSERVER
 #define STRUCTBX_WEBSERVER
 
+#include "Poco/DateTimeFormat.h"
+#include "Poco/DateTimeFormatter.h"
+#include "Poco/DateTimeParser.h"
+#include "Poco/StringTokenizer.h"
+
 #include "core/nebula_atom.h"
 #include "handlers/root_handler.h"
 
+#include "tools/worker_model.h"
+#include "tools/asset_cache.h"
+#include "tools/file_sender.h"
+
 using namespace NAF;
 
 namespace StructBX
@@ -24,6 +33,11 @@ class StructBX::Webserver : public Handlers::RootHandler
         void Process_();
         void DownloadProcess_();
 
+    protected:
+        void SendAsset_(const StructBX::Tools::AssetCache::Asset& asset);
+        void SetupCaching_(const StructBX::Tools::AssetCache::Validator& validator, std::string etag, std::string path);
+        bool NotModified_(const StructBX::Tools::AssetCache::Validator& validator, std::string etag);
+
     private:
         Files::FileManager file_manager_;
 };